@@ -0,0 +1,102 @@
+/*
+Bellman-Ford relaxation rounds
+
+The round-based core shared by Bellman-Ford and Johnson's algorithm. Every round
+relaxes all edges of the graph; without a negative cycle no shortest path has
+more than |V| - 1 edges, so |V| - 1 rounds suffice and a change in round |V|
+proves that a negative cycle exists. The parent pointers then lead back into
+that cycle, which is reported with the exception.
+
+bellmanFordPotentials() runs the rounds from a virtual source with a 0-weight
+edge to every node. The resulting h(v) <= 0 make every reduced weight
+w + h(u) - h(v) non-negative, which is how Johnson's algorithm can use Dijkstra.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Compressed Sparse Row Graph.h"
+
+// thrown when the graph contains a negative cycle, so that no shortest distances exist
+class NegativeCycleException : public std::runtime_error {
+	std::vector<int> cycle;
+
+public:
+	NegativeCycleException(std::vector<int> _cycle)
+		: std::runtime_error("The graph contains a negative cycle.")
+		, cycle{ std::move(_cycle) } {}
+
+	// the nodes of the cycle in edge order, the last one has an edge back to the first
+	const std::vector<int>& getCycle() const { return cycle; }
+};
+
+// node whose parent chain runs into a cycle -> the nodes of that cycle, empty if
+// the chain ends at a node without parent (-1) instead
+inline std::vector<int> extractNegativeCycle(const std::vector<int>& parents, int node) {
+	int n = static_cast<int>(parents.size());
+	// after n steps back we are certainly on the cycle
+	for (int i = 0; i < n; ++i) {
+		if (parents[node] == -1) {
+			return {};
+		}
+		node = parents[node];
+	}
+
+	std::vector<int> cycle{ node };
+	for (int u = parents[node]; u != node; u = parents[u]) {
+		cycle.push_back(u);
+	}
+	std::reverse(cycle.begin(), cycle.end());
+	return cycle;
+}
+
+// relaxes all edges until nothing changes, at most |V| rounds. Nodes at unreached
+// are skipped, so that unreached + w never looks like a real distance. Returns the
+// node changed last in round |V| if there is a negative cycle, -1 otherwise
+inline int relaxInRounds(CsrGraphView graph, std::vector<int>& distances, std::vector<int>& parents, int unreached) {
+	int n = graph.size();
+	bool changed = true;
+	int lastChanged = -1;
+	int executions = 0;
+	while (changed && executions < n) {
+		changed = false;
+		executions++;
+		for (int u = 0; u < n; ++u) {
+			if (distances[u] == unreached) continue;
+
+			for (int e = graph.edgeBegin(u); e < graph.edgeEnd(u); ++e) {
+				int v = graph.target(e),
+					w = graph.weight(e);
+				if (distances[u] + w < distances[v]) {
+					distances[v] = distances[u] + w;
+					parents[v] = u;
+					changed = true;
+					lastChanged = v;
+				}
+			}
+		}
+	}
+	return changed ? lastChanged : -1;
+}
+
+// h(v) from a virtual source: it reaches every node with distance 0, so all
+// potentials start at 0 and are only ever lowered by negative edges. Paths from
+// the virtual source have at most |V| edges and the initialization already took
+// the first one, so the same |V| rounds decide. Throws NegativeCycleException
+inline std::vector<int> bellmanFordPotentials(CsrGraphView graph) {
+	int n = graph.size();
+	std::vector<int> potentials(n, 0);
+	std::vector<int> parents(n, -1);
+
+	// every node is reached, INT_MIN only stands in for "nothing to skip"
+	int lastChanged = relaxInRounds(graph, potentials, parents, INT_MIN);
+	if (lastChanged != -1) {
+		throw NegativeCycleException(extractNegativeCycle(parents, lastChanged));
+	}
+	return potentials;
+}
@@ -4,49 +4,273 @@ Bellman-Ford - Single Source Shortest Paths (SSSP)
 
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <atomic>
+
+#include "Bellman-Ford Relaxation.h"
+#include "Compressed Sparse Row Graph.h"
+#include "Thread Pool.h"
+
 using namespace std;
 
 namespace {
     typedef vector<vector<pair<int, int>>> AdjacencyList;
     constexpr int INF = 1'000'000'000;
+
     class BellmannFord {
     private:
-        AdjacencyList adjacencyList;
-         
+        // set only when constructed from an adjacency list, keeps the graph alive
+        shared_ptr<const CsrGraph> ownedGraph;
+        CsrGraphView graph;
+
+        // parent of the start node and of unreached nodes
+        static constexpr int NO_PARENT = -1;
+
     public:
-        BellmannFord(AdjacencyList _adjacencyList)
-            : adjacencyList{ _adjacencyList }
+        BellmannFord(const AdjacencyList& _adjacencyList)
+            : ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+            , graph{ ownedGraph->view() }
         {}
 
+        // zero-copy: the caller keeps the weighted CsrGraph alive,
+        // throws invalid_argument if it has no weights
+        BellmannFord(CsrGraphView _graph)
+            : graph{ requireWeights(_graph) }
+        {}
+
+        // unreachable nodes keep INF, throws NegativeCycleException
         vector<int> computeDistances(int start) {
-            int n = this->adjacencyList.size();
-            vector<int> distances(n, INFINITY);
+            int n = this->graph.size();
+            if (start < 0 || start >= n) {
+                throw out_of_range("Start node is not a node of the graph.");
+            }
+            vector<int> distances(n, INF);
+            vector<int> parents(n, NO_PARENT);
             distances[start] = 0;
             
-            // keep track of changes in distances
+            // (|V| - 1) rounds suffice without a negative cycle reachable from
+            // start, so a change in round |V| proves there is one
+            int lastChanged = relaxInRounds(this->graph, distances, parents, INF);
+            if (lastChanged != -1) {
+                throw NegativeCycleException(extractNegativeCycle(parents, lastChanged));
+            }
+
+            return distances;
+        }
+
+        // queue-based Bellman-Ford (SPFA): only the out-edges of nodes whose distance
+        // changed are relaxed again. Small Label First puts a node that is closer than
+        // the front of the queue at the front, Large Label Last sends a front node that
+        // is farther than the queue average to the back. Same results and exceptions
+        // as computeDistances
+        vector<int> computeDistancesSpfa(int start) {
+            int n = this->graph.size();
+            if (start < 0 || start >= n) {
+                throw out_of_range("Start node is not a node of the graph.");
+            }
+            vector<int> distances(n, INF);
+            vector<int> parents(n, NO_PARENT);
+            // edges on the current path to each node, reaching n means a cycle
+            vector<int> pathLengths(n, 0);
+            vector<bool> queued(n, false);
+
+            deque<int> active;
+            long long queuedSum = 0;
+
+            distances[start] = 0;
+            active.push_back(start);
+            queued[start] = true;
+
+            while (!active.empty()) {
+                // Large Label Last
+                long long average = queuedSum / (long long)active.size();
+                for (size_t moved = 0; moved < active.size() && distances[active.front()] > average; ++moved) {
+                    active.push_back(active.front());
+                    active.pop_front();
+                }
+
+                int u = active.front();
+                active.pop_front();
+                queued[u] = false;
+                queuedSum -= distances[u];
+
+                for (int e = this->graph.edgeBegin(u); e < this->graph.edgeEnd(u); ++e) {
+                    int v = this->graph.target(e), 
+                        w = this->graph.weight(e);
+                    if (distances[u] + w >= distances[v]) continue;
+
+                    if (queued[v]) {
+                        queuedSum -= distances[v];
+                    }
+                    distances[v] = distances[u] + w;
+                    parents[v] = u;
+                    pathLengths[v] = pathLengths[u] + 1;
+
+                    // a walk of n edges repeats a node, and since every step strictly
+                    // improved a distance the repeated part has negative weight
+                    if (pathLengths[v] >= n) {
+                        vector<int> cycle = extractNegativeCycle(parents, v);
+                        if (cycle.empty()) {
+                            // the cycle is not in the current parent pointers,
+                            // the round-based version is guaranteed to report it
+                            computeDistances(start);
+                        }
+                        throw NegativeCycleException(cycle);
+                    }
+
+                    if (queued[v]) {
+                        queuedSum += distances[v];
+                        continue;
+                    }
+
+                    // Small Label First
+                    if (!active.empty() && distances[v] < distances[active.front()]) {
+                        active.push_front(v);
+                    }
+                    else {
+                        active.push_back(v);
+                    }
+                    queued[v] = true;
+                    queuedSum += distances[v];
+                }
+            }
+
+            return distances;
+        }
+    };
+
+    // Bellman-Ford over a flat edge list in structure-of-arrays form: source[e],
+    // target[e] and weight[e]. The targets and weights are the CSR arrays themselves,
+    // only the sources are stored extra. Every round relaxes all edges in parallel
+    // chunks; candidates are computed from the distances of the previous round, so
+    // that loop is a plain gather-add the compiler can vectorize, and improvements
+    // are applied with an atomic min
+    class ParallelBellmannFord {
+    private:
+        // set only when constructed from an adjacency list, keeps the graph alive
+        shared_ptr<const CsrGraph> ownedGraph;
+        CsrGraphView graph;
+        vector<int> sources;
+
+        int threadCount = 0;
+        shared_ptr<ThreadPool> threadPool;
+
+        // edges per chunk handed to a worker, and per vectorized block
+        static constexpr size_t GRAIN = 16384;
+        static constexpr size_t BLOCK = 256;
+
+        static bool atomicMin(atomic<int>& value, int candidate) {
+            int current = value.load(memory_order_relaxed);
+            while (candidate < current) {
+                if (value.compare_exchange_weak(current, candidate, memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void initializeSources() {
+            sources.resize(graph.edgeCount());
+            for (int u = 0; u < graph.size(); ++u) {
+                fill(sources.begin() + graph.edgeBegin(u), sources.begin() + graph.edgeEnd(u), u);
+            }
+        }
+
+    public:
+        ParallelBellmannFord(const AdjacencyList& _adjacencyList)
+            : ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+            , graph{ ownedGraph->view() }
+        {
+            initializeSources();
+        }
+
+        // zero-copy: the caller keeps the weighted CsrGraph alive,
+        // throws invalid_argument if it has no weights
+        ParallelBellmannFord(CsrGraphView _graph)
+            : graph{ requireWeights(_graph) }
+        {
+            initializeSources();
+        }
+
+        // 0 uses one thread per hardware thread
+        void setThreadCount(int _threadCount) {
+            threadCount = _threadCount;
+            threadPool.reset();
+        }
+
+        // same results and exceptions as BellmannFord::computeDistances
+        vector<int> computeDistances(int start) {
+            int n = graph.size();
+            if (start < 0 || start >= n) {
+                throw out_of_range("Start node is not a node of the graph.");
+            }
+            if (!threadPool) {
+                threadPool = make_shared<ThreadPool>(threadCount);
+            }
+            ThreadPool& workers = *threadPool;
+
+            vector<int> previous(n, INF);
+            unique_ptr<atomic<int>[]> current(new atomic<int>[n]);
+            for (int v = 0; v < n; ++v) {
+                current[v].store(INF, memory_order_relaxed);
+            }
+            previous[start] = 0;
+            current[start].store(0, memory_order_relaxed);
+
+            const int* source = sources.data();
+            const int* target = graph.edgeTargets().begin();
+            const int* weight = graph.edgeWeights().begin();
+            const int* distances = previous.data();
+
             bool changed = true;
-            
-            // count executions of step (2), run at most (|V| - 1)
             int executions = 0;
-            do {
-                changed = false;
+            while (changed && executions < n) {
                 executions++;
+                atomic<bool> anyChange{ false };
 
-                // try to relax all edges
-                for (int u = 0; u < n; ++u) {
-                    for (pair<int, int> entry : this->adjacencyList[u]) {
-                        int v = entry.first, 
-                            w = entry.second;
-                        if (distances[u] + w < distances[v]) {
-                            distances[v] = distances[u] + w;
-                            // keep track of the change
-                            changed = true;
+                workers.parallelFor(sources.size(), GRAIN, [&](int, size_t begin, size_t end) {
+                    int candidates[BLOCK];
+                    bool localChange = false;
+                    for (size_t block = begin; block < end; block += BLOCK) {
+                        size_t length = min(BLOCK, end - block);
+
+                        // gather the source distances, unreached sources stay at INF
+                        for (size_t i = 0; i < length; ++i) {
+                            int distance = distances[source[block + i]];
+                            candidates[i] = distance == INF ? INF : distance + weight[block + i];
                         }
+
+                        for (size_t i = 0; i < length; ++i) {
+                            if (candidates[i] < distances[target[block + i]]) {
+                                localChange |= atomicMin(current[target[block + i]], candidates[i]);
+                            }
+                        }
+                    }
+                    if (localChange) {
+                        anyChange.store(true, memory_order_relaxed);
                     }
+                });
+
+                changed = anyChange.load();
+                if (changed) {
+                    workers.parallelFor(n, GRAIN, [&](int, size_t begin, size_t end) {
+                        for (size_t v = begin; v < end; ++v) {
+                            previous[v] = current[v].load(memory_order_relaxed);
+                        }
+                    });
                 }
-            } while (changed && executions < n - 1);
+            }
 
-            return distances;
+            if (changed) {
+                // a change in round |V| means a negative cycle, let the sequential
+                // version find and report it
+                BellmannFord(graph).computeDistances(start);
+            }
+
+            return previous;
         }
     };
 
@@ -78,4 +302,24 @@ void testBellmannFord() {
         cout << u << " ";
     }
     cout << endl;
+
+    cout << "Same distances with SPFA: " << (bellmannFord.computeDistancesSpfa(0) == path02) << endl;
+
+    ParallelBellmannFord parallel(adjacencyList);
+    parallel.setThreadCount(4);
+    cout << "Same distances in parallel: " << (parallel.computeDistances(0) == path02) << endl;
+
+    // 1 -> 3 -> 1 becomes a negative cycle
+    adjacencyList[1].push_back(make_pair(3, -2));
+    BellmannFord withCycle(adjacencyList);
+    try {
+        withCycle.computeDistancesSpfa(0);
+    }
+    catch (NegativeCycleException exc) {
+        cout << "Negative cycle:";
+        for (int u : exc.getCycle()) {
+            cout << " " << u;
+        }
+        cout << endl;
+    }
 }
\ No newline at end of file
@@ -3,59 +3,338 @@ Bipartite Graph
 
 Apply graph traversal algorithms to check whether a graph is bipartite.
 
+BipartiteCheck colors the nodes in a DFS. ParallelBipartiteCheck colors them by
+BFS level on a thread pool: a node on an even level is red, on an odd level blue,
+so an edge between two nodes whose levels have the same parity closes an odd
+cycle. All workers stop at the first such edge, and the BFS tree gives the odd
+cycle through it as a witness.
+
 */
 
+#include <iostream>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Depth-First Traversal.h"
+#include "Thread Pool.h"
+
 using namespace std;
 
 typedef vector<vector<int>> AdjacencyList;
 enum class NodeState { UNVISITED, RED, BLUE };
 
+const int UNKNOWN = -1;
+
 namespace {
 
+    class GraphIsNotBipartiteException : public runtime_error {
+    public:
+        GraphIsNotBipartiteException() : runtime_error("The graph is not bipartite.") {}
+    };
+
     class BipartiteCheck {
     private:
-        AdjacencyList adjacencyList;
+        // set only when constructed from an adjacency list, keeps the graph alive
+        shared_ptr<const CsrGraph> ownedGraph;
+        CsrGraphView graph;
         vector<NodeState> states;
+        DepthFirstSearch search;
+
+        // colors every node discovered in the other color than its DFS parent and
+        // stops at the first edge between two nodes of the same color
+        struct Visitor : DfsVisitor {
+            vector<NodeState>& states;
+
+            explicit Visitor(vector<NodeState>& _states) : states{ _states } {}
+
+            bool discover(int u, int parent) {
+                states[u] = parent == NO_PARENT || states[parent] == NodeState::BLUE
+                    ? NodeState::RED : NodeState::BLUE;
+                return true;
+            }
+
+            // tree edges are valid by construction, all others are checked here
+            bool backEdge(int u, int v) { return states[u] != states[v]; }
+            bool forwardOrCrossEdge(int u, int v) { return states[u] != states[v]; }
+        };
 
     public:
-        BipartiteCheck(AdjacencyList _adjacencyList)
-            : adjacencyList{ _adjacencyList }
+        BipartiteCheck(const AdjacencyList& _adjacencyList)
+            : ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+            , graph{ ownedGraph->view() }
             , states{ vector<NodeState>(_adjacencyList.size(), NodeState::UNVISITED) }
+            , search{ graph }
+        {}
+
+        // zero-copy: the caller keeps the CsrGraph alive
+        BipartiteCheck(CsrGraphView _graph)
+            : graph{ _graph }
+            , states{ vector<NodeState>(_graph.size(), NodeState::UNVISITED) }
+            , search{ graph }
         {}
 
         bool isBipartite() {
-            // perform dfs
-            for (int u = 0; u < adjacencyList.size(); ++i) {
-                if (states[u] == NodeState::UNVISITED) {
-                    dfs(u, true);
-                }
+            search.reset();
+            states.assign(graph.size(), NodeState::UNVISITED);
+            Visitor visitor(states);
+            return search.runAll(visitor);
+        }
+    };
+
+    // the two sides of a bipartite graph, bit u % 64 of word u / 64 is set for node u
+    struct Bipartition {
+        vector<uint64_t> red;
+        vector<uint64_t> blue;
+
+        bool isRed(int u) const { return (red[u >> 6] >> (u & 63)) & 1; }
+        bool isBlue(int u) const { return (blue[u >> 6] >> (u & 63)) & 1; }
+    };
+
+    // expects an undirected graph with both directions of every edge stored,
+    // otherwise the odd cycle may not exist
+    class ParallelBipartiteCheck {
+    private:
+        // set only when constructed from an adjacency list, keeps the graph alive
+        shared_ptr<const CsrGraph> ownedGraph;
+        CsrGraphView graph;
+
+        // BFS level of every node, UNKNOWN until claimed with compare-and-swap
+        unique_ptr<atomic<int>[]> levels;
+        // BFS tree, written only by the worker that claimed the node
+        vector<int> parents;
+        vector<int> oddCycle;
+        // result of the last isBipartite(), if there was one
+        bool checked = false;
+        bool bipartite = false;
+
+        int threadCount = 0;
+        shared_ptr<ThreadPool> threadPool;
+        static constexpr size_t GRAIN = 64;
+
+        ThreadPool& pool() {
+            if (!threadPool) {
+                threadPool = make_shared<ThreadPool>(threadCount);
             }
+            return *threadPool;
+        }
+
+        // level-synchronous BFS from root; false and the conflicting edge
+        // as soon as any worker sees an edge within one color
+        bool colorComponent(int root, pair<int, int>& conflict) {
+            ThreadPool& workers = pool();
+            atomic<bool> stop{ false };
+            atomic<uint64_t> conflictEdge{ 0 };
+
+            levels[root].store(0, memory_order_relaxed);
+            parents[root] = root;
+
+            vector<int> frontier{ root };
+            vector<vector<int>> localNext(workers.size());
+            vector<size_t> localOffsets(workers.size() + 1);
 
-            // check for invalid edges between nodes of the same color
-            for (int u = 0; u < this->adjacencyList.size(); ++u) {
-                for (int v : this->adjacencyList[u]) {
-                    if (this->states[u] == this->states[v]) {
-                        return false;
+            for (int level = 0; !frontier.empty(); ++level) {
+                workers.parallelFor(frontier.size(), GRAIN, [&](int worker, size_t begin, size_t end) {
+                    vector<int>& next = localNext[worker];
+                    for (size_t i = begin; i < end; ++i) {
+                        if (stop.load(memory_order_relaxed)) return;
+
+                        int u = frontier[i];
+                        for (int v : graph.neighbors(u)) {
+                            int expected = levels[v].load(memory_order_relaxed);
+                            if (expected == UNKNOWN
+                                && levels[v].compare_exchange_strong(expected, level + 1, memory_order_relaxed)) {
+                                parents[v] = u;
+                                next.push_back(v);
+                            }
+                            // a lost race means another worker put v on the next level
+                            else if (expected != UNKNOWN && ((expected ^ level) & 1) == 0) {
+                                bool first = false;
+                                if (stop.compare_exchange_strong(first, true, memory_order_relaxed)) {
+                                    conflictEdge.store(uint64_t(uint32_t(u)) << 32 | uint32_t(v), memory_order_relaxed);
+                                }
+                                return;
+                            }
+                        }
+                    }
+                });
+
+                if (stop.load(memory_order_relaxed)) {
+                    uint64_t edge = conflictEdge.load(memory_order_relaxed);
+                    conflict = { int(edge >> 32), int(edge & 0xFFFFFFFFu) };
+                    for (auto& next : localNext) {
+                        next.clear();
                     }
+                    return false;
                 }
-            }
 
-            // no invalid edge found, graph is bipartite
+                // concatenate the local buffers into the next frontier
+                for (size_t worker = 0; worker < localNext.size(); ++worker) {
+                    localOffsets[worker + 1] = localOffsets[worker] + localNext[worker].size();
+                }
+                frontier.resize(localOffsets.back());
+                workers.run([&](int worker) {
+                    copy(localNext[worker].begin(), localNext[worker].end(), frontier.begin() + localOffsets[worker]);
+                    localNext[worker].clear();
+                });
+            }
             return true;
         }
 
+        // the edge u - v joins two nodes of the same level parity, so the tree paths
+        // from both up to their lowest common ancestor and the edge form an odd cycle
+        void buildOddCycle(int u, int v) {
+            vector<int> fromU{ u };
+            vector<int> fromV{ v };
+            int a = u;
+            int b = v;
+            while (a != b) {
+                int levelA = levels[a].load(memory_order_relaxed);
+                int levelB = levels[b].load(memory_order_relaxed);
+                if (levelA == 0 && levelB == 0) {
+                    // different trees, only possible if an edge is stored in one direction
+                    return;
+                }
+                if (levelA >= levelB) {
+                    a = parents[a];
+                    fromU.push_back(a);
+                }
+                if (levelB >= levelA && a != b) {
+                    b = parents[b];
+                    fromV.push_back(b);
+                }
+            }
+
+            // ancestor .. u, then v .. the child of the ancestor below v
+            fromV.pop_back();
+            oddCycle.assign(fromU.rbegin(), fromU.rend());
+            oddCycle.insert(oddCycle.end(), fromV.begin(), fromV.end());
+        }
+
+    public:
+        ParallelBipartiteCheck(const AdjacencyList& _adjacencyList)
+            : ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+            , graph{ ownedGraph->view() }
+            , levels(new atomic<int>[_adjacencyList.size()])
+            , parents(_adjacencyList.size(), UNKNOWN)
+        {}
+
+        // zero-copy: the caller keeps the CsrGraph alive
+        ParallelBipartiteCheck(CsrGraphView _graph)
+            : graph{ _graph }
+            , levels(new atomic<int>[_graph.size()])
+            , parents(_graph.size(), UNKNOWN)
+        {}
+
+        // 0 uses one thread per hardware thread
+        void setThreadCount(int _threadCount) {
+            threadCount = _threadCount;
+            threadPool.reset();
+        }
+
+        bool isBipartite() {
+            int n = graph.size();
+            pool().parallelFor(n, 4096, [&](int, size_t begin, size_t end) {
+                for (size_t v = begin; v < end; ++v) {
+                    levels[v].store(UNKNOWN, memory_order_relaxed);
+                }
+            });
+            oddCycle.clear();
+            checked = true;
+            bipartite = false;
 
-        void dfs(int u, bool red) {
-            // color the node
-            this->states[u] = red ? NodeState::RED : NodeState::BLUE;
+            for (int root = 0; root < n; ++root) {
+                if (levels[root].load(memory_order_relaxed) != UNKNOWN) continue;
 
-            // check neighbors and color them in the other color
-            for (int v : this->adjacencyList[u]) {
-                if (this->states[v] == NodeState::UNVISITED) {
-                    dfs(v, !red);
+                pair<int, int> conflict;
+                if (!colorComponent(root, conflict)) {
+                    buildOddCycle(conflict.first, conflict.second);
+                    return false;
                 }
             }
+            bipartite = true;
+            return true;
+        }
+
+        // the nodes of an odd cycle in edge order, the last one has an edge back to the first;
+        // empty if the last isBipartite() returned true
+        const vector<int>& getOddCycle() const { return oddCycle; }
+
+        // throws GraphIsNotBipartiteException
+        Bipartition getPartition() {
+            if (!checked) {
+                isBipartite();
+            }
+            if (!bipartite) {
+                throw GraphIsNotBipartiteException();
+            }
+
+            int n = graph.size();
+            size_t words = (size_t(n) + 63) / 64;
+            Bipartition partition{ vector<uint64_t>(words, 0), vector<uint64_t>(words, 0) };
+            // one word per index, so no two workers write the same word
+            pool().parallelFor(words, 64, [&](int, size_t begin, size_t end) {
+                for (size_t word = begin; word < end; ++word) {
+                    int last = int(min(size_t(n), (word + 1) * 64));
+                    for (int u = int(word * 64); u < last; ++u) {
+                        uint64_t bit = uint64_t(1) << (u & 63);
+                        if (levels[u].load(memory_order_relaxed) & 1) {
+                            partition.blue[word] |= bit;
+                        }
+                        else {
+                            partition.red[word] |= bit;
+                        }
+                    }
+                }
+            });
+            return partition;
         }
     };
-}  // namespace
\ No newline at end of file
+}  // namespace
+
+void testBipartiteCheck() {
+    // an even cycle 0 - 1 - 2 - 3 with a pendant node 4, stored in both directions
+    int n = 5;
+    vector<pair<int, int>> edges{ {0, 1}, {1, 2}, {2, 3}, {3, 0}, {3, 4} };
+    AdjacencyList adjacencyList(n);
+    for (auto& edge : edges) {
+        adjacencyList[edge.first].push_back(edge.second);
+        adjacencyList[edge.second].push_back(edge.first);
+    }
+
+    BipartiteCheck check(adjacencyList);
+    cout << "Bipartite: " << check.isBipartite() << endl;
+
+    ParallelBipartiteCheck parallel(adjacencyList);
+    parallel.setThreadCount(4);
+    cout << "Bipartite in parallel: " << parallel.isBipartite() << endl;
+    Bipartition partition = parallel.getPartition();
+    cout << "Red:";
+    for (int u = 0; u < n; ++u) {
+        if (partition.isRed(u)) cout << " " << u;
+    }
+    cout << endl << "Blue:";
+    for (int u = 0; u < n; ++u) {
+        if (partition.isBlue(u)) cout << " " << u;
+    }
+    cout << endl;
+
+    // 2 - 4 closes the odd cycle 2 - 3 - 4
+    adjacencyList[2].push_back(4);
+    adjacencyList[4].push_back(2);
+    BipartiteCheck withOddCycle(adjacencyList);
+    cout << "Bipartite after adding 2 - 4: " << withOddCycle.isBipartite() << endl;
+
+    ParallelBipartiteCheck parallelWithOddCycle(adjacencyList);
+    parallelWithOddCycle.setThreadCount(4);
+    parallelWithOddCycle.isBipartite();
+    cout << "Odd cycle:";
+    for (int u : parallelWithOddCycle.getOddCycle()) {
+        cout << " " << u;
+    }
+    cout << endl;
+}
@@ -0,0 +1,269 @@
+/*
+Compressed Sparse Row (CSR) graph
+
+One flat representation shared by all the algorithms in this repository.
+The out-edges of node u are stored contiguously in
+	targets[offsets[u]] .. targets[offsets[u + 1] - 1]
+and, for weighted graphs, the matching weights live in a parallel array.
+Scanning the neighbors of a node is therefore a sequential read instead of
+chasing one heap pointer per node as with vector<vector<int>>.
+
+CsrGraph owns the arrays, CsrGraphView is a cheap non-owning view of them
+that the algorithm classes keep, so several algorithms can run over a single
+copy of the graph.
+*/
+
+#pragma once
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// half-open range of contiguous ints, used for neighbor and weight lists
+class IntRange {
+	const int* first;
+	const int* last;
+
+public:
+	IntRange(const int* _first, const int* _last)
+		: first{ _first }
+		, last{ _last } {}
+
+	const int* begin() const { return first; }
+	const int* end() const { return last; }
+	int size() const { return static_cast<int>(last - first); }
+	bool empty() const { return first == last; }
+	int operator[](int i) const { return first[i]; }
+};
+
+class CsrGraphView {
+	const int* offsets = nullptr;
+	const int* targets = nullptr;
+	const int* weights = nullptr;
+	int nodeCount = 0;
+
+public:
+	CsrGraphView() = default;
+
+	CsrGraphView(const int* _offsets, const int* _targets, const int* _weights, int _nodeCount)
+		: offsets{ _offsets }
+		, targets{ _targets }
+		, weights{ _weights }
+		, nodeCount{ _nodeCount } {}
+
+	int size() const { return nodeCount; }
+	int edgeCount() const { return nodeCount == 0 ? 0 : offsets[nodeCount]; }
+	bool isWeighted() const { return weights != nullptr; }
+
+	int degree(int u) const { return offsets[u + 1] - offsets[u]; }
+
+	// position of the first out-edge of u in the edge arrays
+	int edgeBegin(int u) const { return offsets[u]; }
+	int edgeEnd(int u) const { return offsets[u + 1]; }
+	int target(int edge) const { return targets[edge]; }
+	int weight(int edge) const { return weights[edge]; }
+
+	IntRange neighbors(int u) const {
+		return IntRange(targets + offsets[u], targets + offsets[u + 1]);
+	}
+
+	// only valid for weighted graphs, parallel to neighbors(u)
+	IntRange neighborWeights(int u) const {
+		return IntRange(weights + offsets[u], weights + offsets[u + 1]);
+	}
+
+	// the whole target and weight arrays, indexed by edge position
+	IntRange edgeTargets() const { return IntRange(targets, targets + edgeCount()); }
+	IntRange edgeWeights() const { return IntRange(weights, weights + edgeCount()); }
+
+	// the same nodes and edges with another weight array in edge order, e.g. reweighted edges
+	CsrGraphView withWeights(const int* _weights) const {
+		return CsrGraphView(offsets, targets, _weights, nodeCount);
+	}
+};
+
+// the shortest path algorithms read a weight for every edge, an unweighted
+// graph has none and would be dereferenced through a null pointer. Without
+// edges nothing is read: the empty weight array of a weighted CsrGraph may
+// have no data pointer at all
+inline CsrGraphView requireWeights(CsrGraphView graph) {
+	if (!graph.isWeighted() && graph.edgeCount() > 0) {
+		throw std::invalid_argument("The algorithm requires a weighted graph.");
+	}
+	return graph;
+}
+
+class CsrGraph {
+	std::vector<int> offsets;
+	std::vector<int> targets;
+	std::vector<int> weights;
+	bool weighted = false;
+
+public:
+	CsrGraph() : offsets(1, 0) {}
+
+	// build from the unweighted adjacency lists used by the traversal algorithms
+	explicit CsrGraph(const std::vector<std::vector<int>>& adjacencyList)
+		: offsets(adjacencyList.size() + 1, 0) {
+		for (size_t u = 0; u < adjacencyList.size(); ++u) {
+			offsets[u + 1] = offsets[u] + static_cast<int>(adjacencyList[u].size());
+		}
+
+		targets.reserve(offsets.back());
+		for (auto& neighbors : adjacencyList) {
+			targets.insert(targets.end(), neighbors.begin(), neighbors.end());
+		}
+	}
+
+	// build from the weighted (target, weight) adjacency lists used by the SSSP algorithms
+	explicit CsrGraph(const std::vector<std::vector<std::pair<int, int>>>& adjacencyList)
+		: offsets(adjacencyList.size() + 1, 0)
+		, weighted{ true } {
+		for (size_t u = 0; u < adjacencyList.size(); ++u) {
+			offsets[u + 1] = offsets[u] + static_cast<int>(adjacencyList[u].size());
+		}
+
+		targets.reserve(offsets.back());
+		weights.reserve(offsets.back());
+		for (auto& neighbors : adjacencyList) {
+			for (auto& entry : neighbors) {
+				targets.push_back(entry.first);
+				weights.push_back(entry.second);
+			}
+		}
+	}
+
+	// adopt already built arrays, used by the builder and by transpose()
+	CsrGraph(std::vector<int> _offsets, std::vector<int> _targets, std::vector<int> _weights, bool _weighted)
+		: offsets(std::move(_offsets))
+		, targets(std::move(_targets))
+		, weights(std::move(_weights))
+		, weighted{ _weighted } {}
+
+	int size() const { return static_cast<int>(offsets.size()) - 1; }
+	int edgeCount() const { return static_cast<int>(targets.size()); }
+	bool isWeighted() const { return weighted; }
+
+	const std::vector<int>& offsetArray() const { return offsets; }
+	const std::vector<int>& targetArray() const { return targets; }
+	const std::vector<int>& weightArray() const { return weights; }
+
+	CsrGraphView view() const& {
+		return CsrGraphView(offsets.data(), targets.data(), weighted ? weights.data() : nullptr, size());
+	}
+
+	// a view of a temporary would dangle
+	CsrGraphView view() const&& = delete;
+
+	operator CsrGraphView() const& { return view(); }
+	operator CsrGraphView() const&& = delete;
+
+	// reverse all edges i.e. {u, v} -> {v, u}, keeping the weights
+	static CsrGraph transposeOf(CsrGraphView graph) {
+		int n = graph.size();
+		std::vector<int> reverseOffsets(n + 1, 0);
+		for (int e = 0; e < graph.edgeCount(); ++e) {
+			reverseOffsets[graph.target(e) + 1]++;
+		}
+		for (int u = 0; u < n; ++u) {
+			reverseOffsets[u + 1] += reverseOffsets[u];
+		}
+
+		std::vector<int> reverseTargets(graph.edgeCount());
+		std::vector<int> reverseWeights(graph.isWeighted() ? graph.edgeCount() : 0);
+		std::vector<int> position(reverseOffsets.begin(), reverseOffsets.end() - 1);
+		for (int u = 0; u < n; ++u) {
+			for (int e = graph.edgeBegin(u); e < graph.edgeEnd(u); ++e) {
+				int slot = position[graph.target(e)]++;
+				reverseTargets[slot] = u;
+				if (graph.isWeighted()) {
+					reverseWeights[slot] = graph.weight(e);
+				}
+			}
+		}
+
+		return CsrGraph(std::move(reverseOffsets), std::move(reverseTargets), std::move(reverseWeights), graph.isWeighted());
+	}
+
+	CsrGraph transpose() const {
+		return transposeOf(view());
+	}
+};
+
+// collects an edge list and turns it into a CsrGraph with a count-then-scatter pass,
+// so no per-node vector is ever allocated or grown
+class CsrGraphBuilder {
+	int nodeCount;
+	bool weighted;
+	std::vector<int> sources;
+	std::vector<int> targets;
+	std::vector<int> weights;
+
+public:
+	explicit CsrGraphBuilder(int _nodeCount, bool _weighted = false)
+		: nodeCount{ _nodeCount }
+		, weighted{ _weighted } {}
+
+	void reserve(size_t edgeCount) {
+		sources.reserve(edgeCount);
+		targets.reserve(edgeCount);
+		if (weighted) {
+			weights.reserve(edgeCount);
+		}
+	}
+
+	void addEdge(int u, int v, int weight = 1) {
+		if (u < 0 || u >= nodeCount || v < 0 || v >= nodeCount) {
+			throw std::out_of_range("Edge endpoint is not a node of the graph.");
+		}
+
+		sources.push_back(u);
+		targets.push_back(v);
+		if (weighted) {
+			weights.push_back(weight);
+		}
+	}
+
+	// edges keep their insertion order within each source node
+	CsrGraph build() const {
+		std::vector<int> offsets(nodeCount + 1, 0);
+		for (int u : sources) {
+			offsets[u + 1]++;
+		}
+		for (int u = 0; u < nodeCount; ++u) {
+			offsets[u + 1] += offsets[u];
+		}
+
+		std::vector<int> csrTargets(targets.size());
+		std::vector<int> csrWeights(weighted ? targets.size() : 0);
+		std::vector<int> position(offsets.begin(), offsets.end() - 1);
+		for (size_t e = 0; e < sources.size(); ++e) {
+			int slot = position[sources[e]]++;
+			csrTargets[slot] = targets[e];
+			if (weighted) {
+				csrWeights[slot] = weights[e];
+			}
+		}
+
+		return CsrGraph(std::move(offsets), std::move(csrTargets), std::move(csrWeights), weighted);
+	}
+
+	// shorthand for the {u, v} and {u, v, w} edge lists used throughout the tests
+	static CsrGraph fromEdges(int nodeCount, const std::vector<std::pair<int, int>>& edges) {
+		CsrGraphBuilder builder(nodeCount);
+		builder.reserve(edges.size());
+		for (auto& edge : edges) {
+			builder.addEdge(edge.first, edge.second);
+		}
+		return builder.build();
+	}
+
+	static CsrGraph fromWeightedEdges(int nodeCount, const std::vector<std::vector<int>>& edges) {
+		CsrGraphBuilder builder(nodeCount, true);
+		builder.reserve(edges.size());
+		for (auto& edge : edges) {
+			builder.addEdge(edge[0], edge[1], edge[2]);
+		}
+		return builder.build();
+	}
+};
@@ -0,0 +1,683 @@
+/*
+Contraction Hierarchies (CH)
+
+Speed-up technique for many shortest path queries on the same static graph.
+
+Preprocessing contracts the nodes one after another in order of importance.
+Contracting v removes it from the remaining graph and adds a shortcut u -> w
+for every path u -> v -> w that is the only shortest path between u and w
+(checked by a bounded "witness" Dijkstra search that avoids v). The order in
+which nodes are contracted is their rank.
+
+A query runs Dijkstra from the start node using only edges to higher ranked
+nodes, and from the end node backwards with the same restriction; both
+searches meet at the highest ranked node of a shortest path. Shortcuts on the
+result are then unpacked back into original edges via the contracted middle
+node stored with each shortcut.
+
+Preprocessing works in rounds: every round contracts an independent set of
+nodes that are less important than all their neighbors, and the contractions
+of one round are simulated in parallel.
+*/
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <fstream>
+#include <string>
+#include <climits>
+#include <cstdio>
+#include <iterator>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Priority Queues.h"
+#include "Thread Pool.h"
+
+using namespace std;
+
+namespace {
+
+	typedef pair<int, int> NodeAndDistance;
+	typedef vector<vector<NodeAndDistance>> AdjacencyList;
+
+	class NoPathExistsException : public runtime_error {
+	public:
+		NoPathExistsException() : runtime_error("No path exists between the nodes.") {}
+	};
+
+	const int UNKNOWN = -1;
+
+	// edges of one search direction of the hierarchy in CSR form. middles[e] is the
+	// node a shortcut bypasses, UNKNOWN for an original edge of the graph
+	struct HierarchyEdges {
+		vector<int> offsets;
+		vector<int> targets;
+		vector<int> weights;
+		vector<int> middles;
+
+		int begin(int u) const { return offsets[u]; }
+		int end(int u) const { return offsets[u + 1]; }
+
+		// the edge of u that leads to target, the hierarchy keeps at most one per pair
+		int find(int u, int target) const {
+			for (int e = offsets[u]; e < offsets[u + 1]; ++e) {
+				if (targets[e] == target) return e;
+			}
+			return UNKNOWN;
+		}
+	};
+
+	class ContractionHierarchy {
+		int nodeCount = 0;
+		vector<int> ranks;
+
+		// upward: u -> w with rank[w] > rank[u], stored at u.
+		// downward: u -> w with rank[u] > rank[w], stored reversed at w, so that the
+		// backward search from the end node also only climbs
+		HierarchyEdges upward;
+		HierarchyEdges downward;
+
+		// query scratch, forward (0) and backward (1), valid when stamped with epoch
+		vector<int> distances[2];
+		vector<int> parents[2];
+		vector<int> parentEdges[2];
+		vector<unsigned> stamps[2];
+		unsigned epoch = 0;
+		unique_ptr<IndexedDaryHeap<4>> queues[2];
+
+		static constexpr char MAGIC[4] = { 'C', 'H', '0', '1' };
+
+		void prepareQueries() {
+			for (int side = 0; side < 2; ++side) {
+				distances[side].assign(nodeCount, 0);
+				parents[side].assign(nodeCount, UNKNOWN);
+				parentEdges[side].assign(nodeCount, UNKNOWN);
+				stamps[side].assign(nodeCount, 0);
+				queues[side].reset(new IndexedDaryHeap<4>(nodeCount));
+			}
+			epoch = 0;
+		}
+
+		int distanceOf(int side, int v) const {
+			return stamps[side][v] == epoch ? distances[side][v] : UNKNOWN;
+		}
+
+		// append the original path of the edge a -> b (a itself excluded)
+		void unpack(int a, int b, int middle, vector<int>& path) const {
+			// (from, to, middle) segments still to expand, leftmost on top
+			vector<pair<pair<int, int>, int>> pending{ { { a, b }, middle } };
+			while (!pending.empty()) {
+				auto segment = pending.back();
+				pending.pop_back();
+
+				int from = segment.first.first, to = segment.first.second, via = segment.second;
+				if (via == UNKNOWN) {
+					path.push_back(to);
+					continue;
+				}
+
+				// from -> via is a downward edge stored at via, via -> to an upward one
+				int first = downward.find(via, from);
+				int second = upward.find(via, to);
+				pending.push_back({ { via, to }, upward.middles[second] });
+				pending.push_back({ { from, via }, downward.middles[first] });
+			}
+		}
+
+		friend class ContractionHierarchyBuilder;
+
+	public:
+		ContractionHierarchy() = default;
+
+		int size() const { return nodeCount; }
+		int getRank(int v) const { return ranks[v]; }
+		int getEdgeCount() const { return static_cast<int>(upward.targets.size() + downward.targets.size()); }
+
+		// same result as Dijkstra::computeShortestPath
+		pair<int, vector<int>> computeShortestPath(int start, int end) {
+			if (++epoch == 0) {
+				prepareQueries();
+				epoch = 1;
+			}
+
+			const HierarchyEdges* edges[2] = { &upward, &downward };
+			int roots[2] = { start, end };
+			bool active[2] = { true, true };
+			for (int side = 0; side < 2; ++side) {
+				stamps[side][roots[side]] = epoch;
+				distances[side][roots[side]] = 0;
+				parents[side][roots[side]] = UNKNOWN;
+				parentEdges[side][roots[side]] = UNKNOWN;
+				queues[side]->update(roots[side], 0);
+			}
+
+			int best = INT_MAX, meeting = UNKNOWN;
+			for (int turn = 0; active[0] || active[1]; ++turn) {
+				int side = active[turn & 1] ? turn & 1 : 1 - (turn & 1);
+				if (queues[side]->empty()) {
+					active[side] = false;
+					continue;
+				}
+
+				auto current = queues[side]->pop();
+				int u = current.first, distance = current.second;
+
+				// nothing this side still has queued can beat the best meeting
+				if (distance >= best) {
+					active[side] = false;
+					continue;
+				}
+
+				int other = distanceOf(1 - side, u);
+				if (other != UNKNOWN && distance + other < best) {
+					best = distance + other;
+					meeting = u;
+				}
+
+				const HierarchyEdges& direction = *edges[side];
+				for (int e = direction.begin(u); e < direction.end(u); ++e) {
+					int v = direction.targets[e];
+					int candidate = distance + direction.weights[e];
+					int known = distanceOf(side, v);
+					if (known == UNKNOWN || candidate < known) {
+						stamps[side][v] = epoch;
+						distances[side][v] = candidate;
+						parents[side][v] = u;
+						parentEdges[side][v] = e;
+						queues[side]->update(v, candidate);
+					}
+				}
+			}
+			queues[0]->clear();
+			queues[1]->clear();
+
+			if (meeting == UNKNOWN) {
+				throw NoPathExistsException();
+			}
+
+			// climb from the meeting node back to start, then unpack every edge
+			vector<int> upwardChain{ meeting };
+			for (int v = meeting; parents[0][v] != UNKNOWN; v = parents[0][v]) {
+				upwardChain.push_back(parents[0][v]);
+			}
+			reverse(upwardChain.begin(), upwardChain.end());
+
+			vector<int> path{ start };
+			for (size_t i = 0; i + 1 < upwardChain.size(); ++i) {
+				int e = parentEdges[0][upwardChain[i + 1]];
+				unpack(upwardChain[i], upwardChain[i + 1], upward.middles[e], path);
+			}
+
+			// the backward search came down from end, its parent edges lead towards end
+			for (int v = meeting; parents[1][v] != UNKNOWN; v = parents[1][v]) {
+				unpack(v, parents[1][v], downward.middles[parentEdges[1][v]], path);
+			}
+
+			return { best, path };
+		}
+
+		void save(const string& fileName) const {
+			ofstream out(fileName, ios::binary);
+			auto writeArray = [&](const vector<int>& values) {
+				int length = static_cast<int>(values.size());
+				out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+				out.write(reinterpret_cast<const char*>(values.data()), sizeof(int) * values.size());
+			};
+
+			out.write(MAGIC, sizeof(MAGIC));
+			out.write(reinterpret_cast<const char*>(&nodeCount), sizeof(nodeCount));
+			writeArray(ranks);
+			for (const HierarchyEdges* edges : { &upward, &downward }) {
+				writeArray(edges->offsets);
+				writeArray(edges->targets);
+				writeArray(edges->weights);
+				writeArray(edges->middles);
+			}
+			if (!out) {
+				throw runtime_error("Could not write the contraction hierarchy to " + fileName);
+			}
+		}
+
+		// the arrays must describe a valid CSR graph over nodeCount nodes, or the
+		// queries would read out of bounds
+		bool isConsistent(const HierarchyEdges& edges) const {
+			if (int(edges.offsets.size()) != nodeCount + 1 || edges.offsets[0] != 0
+				|| edges.offsets.back() != int(edges.targets.size())
+				|| edges.weights.size() != edges.targets.size()
+				|| edges.middles.size() != edges.targets.size()) {
+				return false;
+			}
+			for (int u = 0; u < nodeCount; ++u) {
+				if (edges.offsets[u] > edges.offsets[u + 1]) return false;
+			}
+			for (size_t e = 0; e < edges.targets.size(); ++e) {
+				if (edges.targets[e] < 0 || edges.targets[e] >= nodeCount
+					|| edges.middles[e] < UNKNOWN || edges.middles[e] >= nodeCount
+					|| edges.weights[e] < 0) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// both edge lists lead from lower to higher rank, and a shortcut between a
+		// and b has both halves through a middle ranked below them, so unpack()
+		// finds every half and always ends
+		bool isConsistent() const {
+			if (nodeCount < 0 || int(ranks.size()) != nodeCount || !isConsistent(upward) || !isConsistent(downward)) {
+				return false;
+			}
+			for (int rank : ranks) {
+				if (rank < 0 || rank >= nodeCount) return false;
+			}
+			for (int u = 0; u < nodeCount; ++u) {
+				for (int down = 0; down < 2; ++down) {
+					const HierarchyEdges& edges = down ? downward : upward;
+					for (int e = edges.begin(u); e < edges.end(u); ++e) {
+						int w = edges.targets[e];
+						int middle = edges.middles[e];
+						if (ranks[w] <= ranks[u]) return false;
+						if (middle == UNKNOWN) continue;
+
+						// upward edges are u -> w, downward ones w -> u
+						int from = down ? w : u;
+						int to = down ? u : w;
+						if (ranks[middle] >= ranks[u] || downward.find(middle, from) == UNKNOWN
+							|| upward.find(middle, to) == UNKNOWN) {
+							return false;
+						}
+					}
+				}
+			}
+			return true;
+		}
+
+		static ContractionHierarchy load(const string& fileName) {
+			ifstream in(fileName, ios::binary | ios::ate);
+			// no array can be longer than the rest of the file
+			long long remaining = in ? static_cast<long long>(in.tellg()) : 0;
+			in.seekg(0);
+			auto readArray = [&](vector<int>& values) {
+				int length = 0;
+				in.read(reinterpret_cast<char*>(&length), sizeof(length));
+				if (!in || length < 0 || static_cast<long long>(length) * static_cast<long long>(sizeof(int)) > remaining) {
+					throw runtime_error("Truncated contraction hierarchy: " + fileName);
+				}
+				values.resize(length);
+				in.read(reinterpret_cast<char*>(values.data()), sizeof(int) * values.size());
+			};
+
+			ContractionHierarchy hierarchy;
+			char magic[4] = {};
+			in.read(magic, sizeof(magic));
+			in.read(reinterpret_cast<char*>(&hierarchy.nodeCount), sizeof(hierarchy.nodeCount));
+			if (!in || !equal(magic, magic + 4, MAGIC)) {
+				throw runtime_error("Not a contraction hierarchy: " + fileName);
+			}
+
+			readArray(hierarchy.ranks);
+			for (HierarchyEdges* edges : { &hierarchy.upward, &hierarchy.downward }) {
+				readArray(edges->offsets);
+				readArray(edges->targets);
+				readArray(edges->weights);
+				readArray(edges->middles);
+			}
+			if (!in) {
+				throw runtime_error("Truncated contraction hierarchy: " + fileName);
+			}
+			if (!hierarchy.isConsistent()) {
+				throw runtime_error("Corrupt contraction hierarchy: " + fileName);
+			}
+
+			hierarchy.prepareQueries();
+			return hierarchy;
+		}
+	};
+
+	// offline preprocessing: node ordering and shortcut creation
+	class ContractionHierarchyBuilder {
+		struct Edge {
+			int node;
+			int weight;
+			int middle;
+		};
+
+		struct Shortcut {
+			int from;
+			int to;
+			int weight;
+			int middle;
+		};
+
+		// per-worker state of the bounded witness searches
+		struct WitnessSearch {
+			IndexedDaryHeap<4> queue;
+			vector<int> distances;
+			vector<unsigned> stamps;
+			unsigned epoch = 0;
+
+			explicit WitnessSearch(int n)
+				: queue(n)
+				, distances(n, 0)
+				, stamps(n, 0) {}
+
+			int distanceOf(int v) const { return stamps[v] == epoch ? distances[v] : INT_MAX; }
+		};
+
+		// a witness search gives up after this many settled nodes and the shortcut is
+		// added anyway, which is always correct but may add a redundant edge
+		static constexpr int SETTLE_LIMIT = 500;
+
+		int nodeCount;
+		// every edge ever seen, original or shortcut, at most one per ordered pair
+		vector<vector<Edge>> outEdges;
+		vector<vector<Edge>> inEdges;
+		vector<bool> contracted;
+		vector<int> contractedNeighbors;
+		vector<int> priorities;
+
+		ThreadPool pool;
+		vector<WitnessSearch> witnessSearches;
+
+		// insert u -> w or lower its weight, true if the graph changed
+		bool addEdge(int u, int w, int weight, int middle) {
+			for (Edge& edge : outEdges[u]) {
+				if (edge.node != w) continue;
+				if (edge.weight <= weight) return false;
+
+				edge.weight = weight;
+				edge.middle = middle;
+				for (Edge& reverse : inEdges[w]) {
+					if (reverse.node == u) {
+						reverse.weight = weight;
+						reverse.middle = middle;
+					}
+				}
+				return true;
+			}
+
+			outEdges[u].push_back({ w, weight, middle });
+			inEdges[w].push_back({ u, weight, middle });
+			return true;
+		}
+
+		// Dijkstra from source over the remaining graph without via, up to limit
+		void witnessSearch(WitnessSearch& search, int source, int via, int limit) const {
+			if (++search.epoch == 0) {
+				fill(search.stamps.begin(), search.stamps.end(), 0);
+				search.epoch = 1;
+			}
+
+			search.stamps[source] = search.epoch;
+			search.distances[source] = 0;
+			search.queue.update(source, 0);
+
+			for (int settled = 0; !search.queue.empty() && settled < SETTLE_LIMIT; ++settled) {
+				auto current = search.queue.pop();
+				int u = current.first, distance = current.second;
+				if (distance > limit) break;
+
+				for (const Edge& edge : outEdges[u]) {
+					int v = edge.node;
+					if (v == via || contracted[v]) continue;
+					if (distance + edge.weight < search.distanceOf(v)) {
+						search.stamps[v] = search.epoch;
+						search.distances[v] = distance + edge.weight;
+						search.queue.update(v, distance + edge.weight);
+					}
+				}
+			}
+			search.queue.clear();
+		}
+
+		// the shortcuts contracting v would need right now
+		void simulateContraction(WitnessSearch& search, int v, vector<Shortcut>& shortcuts) const {
+			for (const Edge& in : inEdges[v]) {
+				int u = in.node;
+				if (contracted[u] || u == v) continue;
+
+				int limit = UNKNOWN;
+				for (const Edge& out : outEdges[v]) {
+					if (!contracted[out.node] && out.node != u && out.node != v) {
+						limit = max(limit, in.weight + out.weight);
+					}
+				}
+				if (limit == UNKNOWN) continue;
+
+				witnessSearch(search, u, v, limit);
+				for (const Edge& out : outEdges[v]) {
+					int w = out.node;
+					if (contracted[w] || w == u || w == v) continue;
+					if (search.distanceOf(w) > in.weight + out.weight) {
+						shortcuts.push_back({ u, w, in.weight + out.weight, v });
+					}
+				}
+			}
+		}
+
+		// edge difference plus the number of already contracted neighbors,
+		// the latter spreads the contraction evenly over the graph
+		int priorityOf(WitnessSearch& search, int v, vector<Shortcut>& scratch) const {
+			scratch.clear();
+			simulateContraction(search, v, scratch);
+
+			int removed = 0;
+			for (const Edge& edge : inEdges[v]) removed += !contracted[edge.node];
+			for (const Edge& edge : outEdges[v]) removed += !contracted[edge.node];
+			return int(scratch.size()) - removed + contractedNeighbors[v];
+		}
+
+		// v goes next if it beats every remaining neighbor, ties broken by node id
+		bool isLocalMinimum(int v) const {
+			auto beats = [&](int u) {
+				return contracted[u] || u == v
+					|| priorities[v] < priorities[u]
+					|| (priorities[v] == priorities[u] && v < u);
+			};
+			for (const Edge& edge : inEdges[v]) {
+				if (!beats(edge.node)) return false;
+			}
+			for (const Edge& edge : outEdges[v]) {
+				if (!beats(edge.node)) return false;
+			}
+			return true;
+		}
+
+		void updatePriorities(const vector<int>& nodes) {
+			vector<vector<Shortcut>> scratch(pool.size());
+			pool.parallelFor(nodes.size(), 16, [&](int worker, size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					priorities[nodes[i]] = priorityOf(witnessSearches[worker], nodes[i], scratch[worker]);
+				}
+			});
+		}
+
+	public:
+		// weights must exist and not be negative, threadCount 0 uses every hardware thread
+		explicit ContractionHierarchyBuilder(CsrGraphView graph, int threadCount = 0)
+			: nodeCount{ graph.size() }
+			, outEdges(graph.size())
+			, inEdges(graph.size())
+			, contracted(graph.size(), false)
+			, contractedNeighbors(graph.size(), 0)
+			, priorities(graph.size(), 0)
+			, pool(threadCount) {
+			requireWeights(graph);
+			for (int u = 0; u < nodeCount; ++u) {
+				for (int e = graph.edgeBegin(u); e < graph.edgeEnd(u); ++e) {
+					if (graph.weight(e) < 0) {
+						throw invalid_argument("Contraction hierarchies require non-negative edge weights.");
+					}
+					// self loops never lie on a shortest path, parallel edges keep the lightest
+					if (graph.target(e) != u) {
+						addEdge(u, graph.target(e), graph.weight(e), UNKNOWN);
+					}
+				}
+			}
+			for (int worker = 0; worker < pool.size(); ++worker) {
+				witnessSearches.emplace_back(nodeCount);
+			}
+		}
+
+		ContractionHierarchy build() {
+			vector<int> ranks(nodeCount, UNKNOWN);
+			vector<int> remaining(nodeCount);
+			for (int v = 0; v < nodeCount; ++v) {
+				remaining[v] = v;
+			}
+			updatePriorities(remaining);
+
+			int nextRank = 0;
+			vector<vector<Shortcut>> shortcuts(pool.size());
+			vector<int> independent, touched, neighbors;
+			while (!remaining.empty()) {
+				independent.clear();
+				for (int v : remaining) {
+					if (isLocalMinimum(v)) independent.push_back(v);
+				}
+
+				// contract the whole set at once; no two of its nodes are adjacent and none
+				// of them may serve as a witness for another, so the searches are independent
+				for (int v : independent) {
+					contracted[v] = true;
+					ranks[v] = nextRank++;
+				}
+				pool.parallelFor(independent.size(), 4, [&](int worker, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						simulateContraction(witnessSearches[worker], independent[i], shortcuts[worker]);
+					}
+				});
+				for (auto& local : shortcuts) {
+					for (const Shortcut& shortcut : local) {
+						addEdge(shortcut.from, shortcut.to, shortcut.weight, shortcut.middle);
+					}
+					local.clear();
+				}
+
+				// the neighbors of contracted nodes need a fresh priority
+				touched.clear();
+				for (int v : independent) {
+					neighbors.clear();
+					for (const Edge& edge : inEdges[v]) neighbors.push_back(edge.node);
+					for (const Edge& edge : outEdges[v]) neighbors.push_back(edge.node);
+					sort(neighbors.begin(), neighbors.end());
+					neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+					for (int u : neighbors) {
+						if (contracted[u]) continue;
+						contractedNeighbors[u]++;
+						touched.push_back(u);
+					}
+				}
+				sort(touched.begin(), touched.end());
+				touched.erase(unique(touched.begin(), touched.end()), touched.end());
+				updatePriorities(touched);
+
+				remaining.erase(remove_if(remaining.begin(), remaining.end(), [&](int v) { return contracted[v]; }), remaining.end());
+			}
+
+			return assemble(move(ranks));
+		}
+
+	private:
+		ContractionHierarchy assemble(vector<int> ranks) {
+			ContractionHierarchy hierarchy;
+			hierarchy.nodeCount = nodeCount;
+
+			HierarchyEdges* sides[2] = { &hierarchy.upward, &hierarchy.downward };
+			for (HierarchyEdges* side : sides) {
+				side->offsets.assign(nodeCount + 1, 0);
+			}
+
+			// count, prefix sum, scatter
+			for (int u = 0; u < nodeCount; ++u) {
+				for (const Edge& edge : outEdges[u]) {
+					if (ranks[edge.node] > ranks[u]) hierarchy.upward.offsets[u + 1]++;
+					else hierarchy.downward.offsets[edge.node + 1]++;
+				}
+			}
+			for (HierarchyEdges* side : sides) {
+				for (int u = 0; u < nodeCount; ++u) {
+					side->offsets[u + 1] += side->offsets[u];
+				}
+				side->targets.resize(side->offsets.back());
+				side->weights.resize(side->offsets.back());
+				side->middles.resize(side->offsets.back());
+			}
+
+			vector<int> upPosition(hierarchy.upward.offsets.begin(), hierarchy.upward.offsets.end() - 1);
+			vector<int> downPosition(hierarchy.downward.offsets.begin(), hierarchy.downward.offsets.end() - 1);
+			for (int u = 0; u < nodeCount; ++u) {
+				for (const Edge& edge : outEdges[u]) {
+					bool up = ranks[edge.node] > ranks[u];
+					HierarchyEdges& side = up ? hierarchy.upward : hierarchy.downward;
+					int slot = up ? upPosition[u]++ : downPosition[edge.node]++;
+					side.targets[slot] = up ? edge.node : u;
+					side.weights[slot] = edge.weight;
+					side.middles[slot] = edge.middle;
+				}
+			}
+
+			hierarchy.ranks = move(ranks);
+			hierarchy.prepareQueries();
+			return hierarchy;
+		}
+	};
+}
+
+void testContractionHierarchies() {
+	int n = 5;
+	vector<vector<int>> edges{
+		{0, 1, 6},
+		{0, 2, 10},
+		{0, 3, 4},
+		{1, 0, 2},
+		{1, 2, 3},
+		{1, 4, 5},
+		{3, 1, 1},
+		{3, 4, 2},
+		{4, 2, 1}
+	};
+	CsrGraph graph = CsrGraphBuilder::fromWeightedEdges(n, edges);
+
+	ContractionHierarchy hierarchy = ContractionHierarchyBuilder(graph).build();
+	auto result = hierarchy.computeShortestPath(0, 2);
+
+	cout << "Shortest path from 0 to 2: ";
+	for (int u : result.second) {
+		cout << u << " ";
+	}
+	cout << endl << "Length of the path: " << result.first << endl;
+
+	try {
+		hierarchy.computeShortestPath(2, 0);
+	}
+	catch (NoPathExistsException exc) {
+		cout << "No path from 2 to 0." << endl;
+	}
+
+	// the preprocessing is done once and stored, queries run on the loaded copy
+	string fileName = "contraction_hierarchy_test.ch";
+	hierarchy.save(fileName);
+	ContractionHierarchy loaded = ContractionHierarchy::load(fileName);
+	auto loadedResult = loaded.computeShortestPath(0, 2);
+	cout << "Same path after save and load: "
+		<< (loadedResult.first == result.first && loadedResult.second == result.second) << endl;
+
+	// a file cut short must be rejected instead of read out of bounds
+	{
+		ifstream in(fileName, ios::binary);
+		string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+		in.close();
+		ofstream out(fileName, ios::binary | ios::trunc);
+		out.write(bytes.data(), bytes.size() - sizeof(int));
+	}
+	try {
+		ContractionHierarchy::load(fileName);
+	}
+	catch (runtime_error exc) {
+		cout << "Truncated file rejected." << endl;
+	}
+	remove(fileName.c_str());
+}
@@ -0,0 +1,292 @@
+/*
+Delta-stepping - parallel Single Source Shortest Paths (SSSP)
+
+Meyer and Sanders' relaxation of Dijkstra's algorithm for non-negative weights.
+Tentative distances are grouped into buckets of width delta and all nodes of
+the current bucket are relaxed at once, in parallel:
+	- light edges (weight <= delta) can put nodes back into the current bucket,
+	  so they are relaxed repeatedly until the bucket stays empty,
+	- heavy edges (weight > delta) can only reach later buckets, so they are
+	  relaxed once for every node that was settled in the bucket.
+A small delta behaves like Dijkstra, a large one like Bellman-Ford.
+
+Distances and the parent of every node are packed into one 64 bit word and
+lowered with compare-and-swap, so concurrent relaxations never lose an update.
+*/
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <cstdint>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Thread Pool.h"
+
+using namespace std;
+
+namespace {
+
+	typedef pair<int, int> NodeAndDistance;
+	typedef vector<vector<NodeAndDistance>> AdjacencyList;
+
+	class NoPathExistsException : public runtime_error {
+	public:
+		NoPathExistsException() : runtime_error("No path exists between the nodes.") {}
+	};
+
+	const int UNKNOWN = -1;
+
+	class DeltaStepping {
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
+		vector<int> distances;
+		vector<int> parents;
+
+		int threadCount = 0;
+		shared_ptr<ThreadPool> threadPool;
+
+		// tentative (distance << 32 | parent), replaced only by a shorter distance
+		unique_ptr<atomic<uint64_t>[]> tentative;
+		static constexpr uint64_t UNREACHED = ~uint64_t(0);
+
+		// bucket index a node is currently queued in, UNKNOWN if none
+		vector<long long> queuedIn;
+
+		static constexpr size_t GRAIN = 64;
+
+		static uint64_t pack(int distance, int parent) {
+			return (uint64_t(uint32_t(distance)) << 32) | uint32_t(parent);
+		}
+
+		static int distanceOf(uint64_t word) { return int(word >> 32); }
+		static int parentOf(uint64_t word) { return int(uint32_t(word)); }
+
+		ThreadPool& pool() {
+			if (!threadPool) {
+				threadPool = make_shared<ThreadPool>(threadCount);
+			}
+			return *threadPool;
+		}
+
+		// lower the tentative distance of v, true if this call improved it. An equally
+		// short path must not replace the parent: with zero-weight edges that could
+		// make two nodes each other's parent
+		bool relax(int v, int distance, int parent) {
+			uint64_t candidate = pack(distance, parent);
+			uint64_t current = tentative[v].load(memory_order_relaxed);
+			while (current == UNREACHED || distance < distanceOf(current)) {
+				if (tentative[v].compare_exchange_weak(current, candidate, memory_order_relaxed)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+	public:
+		DeltaStepping(const AdjacencyList& _adjacencyList)
+			: ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+			, graph{ ownedGraph->view() }
+			, distances(_adjacencyList.size(), UNKNOWN)
+			, parents(_adjacencyList.size(), UNKNOWN)
+		{}
+
+		// zero-copy: the caller keeps the weighted CsrGraph alive,
+		// throws invalid_argument if it has no weights
+		DeltaStepping(CsrGraphView _graph)
+			: graph{ requireWeights(_graph) }
+			, distances(_graph.size(), UNKNOWN)
+			, parents(_graph.size(), UNKNOWN)
+		{}
+
+		// 0 uses one thread per hardware thread
+		void setThreadCount(int _threadCount) {
+			threadCount = _threadCount;
+			threadPool.reset();
+		}
+
+		// max weight / average degree: on average about one light edge per node
+		// keeps the buckets busy without re-relaxing the same nodes too often
+		static int autoDelta(CsrGraphView graph) {
+			int maxWeight = 1;
+			for (int e = 0; e < graph.edgeCount(); ++e) {
+				maxWeight = max(maxWeight, graph.weight(e));
+			}
+			double averageDegree = graph.size() == 0 ? 1.0 : double(graph.edgeCount()) / graph.size();
+			return max(1, int(maxWeight / max(1.0, averageDegree)));
+		}
+
+		// delta 0 picks autoDelta(); weights must not be negative
+		void run(int start, int delta = 0) {
+			int n = graph.size();
+			if (delta <= 0) {
+				delta = autoDelta(graph);
+			}
+
+			int maxWeight = 0;
+			for (int e = 0; e < graph.edgeCount(); ++e) {
+				if (graph.weight(e) < 0) {
+					throw invalid_argument("Delta-stepping requires non-negative edge weights.");
+				}
+				maxWeight = max(maxWeight, graph.weight(e));
+			}
+
+			ThreadPool& workers = pool();
+			if (!tentative) {
+				tentative.reset(new atomic<uint64_t>[n]);
+			}
+			workers.parallelFor(n, 4096, [&](int, size_t begin, size_t end) {
+				for (size_t v = begin; v < end; ++v) {
+					tentative[v].store(UNREACHED, memory_order_relaxed);
+				}
+			});
+			queuedIn.assign(n, UNKNOWN);
+
+			// a queued node is never more than maxWeight / delta buckets ahead of
+			// the current one, so the buckets can be reused cyclically
+			size_t slots = size_t(maxWeight / delta) + 2;
+			vector<vector<int>> buckets(slots);
+			size_t queued = 0;
+
+			auto enqueue = [&](int v) {
+				long long index = distanceOf(tentative[v].load(memory_order_relaxed)) / delta;
+				if (queuedIn[v] == index) return;
+				queuedIn[v] = index;
+				buckets[index % slots].push_back(v);
+				queued++;
+			};
+
+			vector<vector<int>> improved(workers.size());
+			auto mergeImproved = [&]() {
+				for (auto& local : improved) {
+					for (int v : local) {
+						enqueue(v);
+					}
+					local.clear();
+				}
+			};
+
+			// relax either the light or the heavy out-edges of all nodes in frontier
+			auto relaxEdges = [&](const vector<int>& frontier, bool light) {
+				workers.parallelFor(frontier.size(), GRAIN, [&](int worker, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						int u = frontier[i];
+						int distance = distanceOf(tentative[u].load(memory_order_relaxed));
+						for (int e = graph.edgeBegin(u); e < graph.edgeEnd(u); ++e) {
+							int weight = graph.weight(e);
+							if ((weight <= delta) != light) continue;
+							if (relax(graph.target(e), distance + weight, u)) {
+								improved[worker].push_back(graph.target(e));
+							}
+						}
+					}
+				});
+				mergeImproved();
+			};
+
+			tentative[start].store(pack(0, start), memory_order_relaxed);
+			enqueue(start);
+
+			vector<int> frontier;
+			vector<int> settled;
+			for (long long index = 0; queued > 0; ++index) {
+				vector<int>& bucket = buckets[index % slots];
+				settled.clear();
+
+				// light phases until the bucket stays empty
+				while (!bucket.empty()) {
+					frontier.clear();
+					for (int v : bucket) {
+						queued--;
+						// skip entries of nodes that moved to an earlier bucket since
+						if (queuedIn[v] != index) continue;
+						queuedIn[v] = UNKNOWN;
+						frontier.push_back(v);
+					}
+					bucket.clear();
+
+					settled.insert(settled.end(), frontier.begin(), frontier.end());
+					relaxEdges(frontier, true);
+				}
+
+				// one heavy phase for everything settled in this bucket
+				relaxEdges(settled, false);
+			}
+
+			workers.parallelFor(n, 4096, [&](int, size_t begin, size_t end) {
+				for (size_t v = begin; v < end; ++v) {
+					uint64_t word = tentative[v].load(memory_order_relaxed);
+					distances[v] = word == UNREACHED ? UNKNOWN : distanceOf(word);
+					parents[v] = word == UNREACHED ? UNKNOWN : parentOf(word);
+				}
+			});
+		}
+
+		// same distances as Dijkstra::runDijkstra; between equally short paths the
+		// parent is the one found first, which can depend on the thread timing
+		const vector<int>& getDistances() const { return distances; }
+		const vector<int>& getParents() const { return parents; }
+
+		pair<int, vector<int>> computeShortestPath(int start, int end, int delta = 0) {
+			run(start, delta);
+
+			if (distances[end] == UNKNOWN) {
+				throw NoPathExistsException();
+			}
+
+			// reconstruct the path from parents
+			vector<int> path;
+			path.push_back(end);
+			int current = end;
+			while (current != start) {
+				current = parents[current];
+				path.push_back(current);
+			}
+
+			reverse(path.begin(), path.end());
+			return { distances[end], path };
+		}
+	};
+}
+
+void testDeltaStepping() {
+	int n = 5;
+	vector<vector<int>> edges{
+		{0, 1, 6},
+		{0, 2, 10},
+		{0, 3, 4},
+		{1, 0, 2},
+		{1, 2, 3},
+		{1, 4, 5},
+		{3, 1, 1},
+		{3, 4, 2},
+		{4, 2, 1}
+	};
+	CsrGraph graph = CsrGraphBuilder::fromWeightedEdges(n, edges);
+
+	DeltaStepping deltaStepping(graph);
+	deltaStepping.setThreadCount(4);
+	for (int delta : { 0, 1, 3, 100 }) {
+		auto result = deltaStepping.computeShortestPath(0, 2, delta);
+
+		cout << "Shortest path from 0 to 2 with delta " << delta << ": ";
+		for (int u : result.second) {
+			cout << u << " ";
+		}
+		cout << endl << "Length of the path: " << result.first << endl;
+	}
+
+	// 0 and 1 reach each other for free, neither may become the parent of the other
+	CsrGraph zeroCycle = CsrGraphBuilder::fromWeightedEdges(4, { {3, 1, 5}, {1, 0, 0}, {0, 1, 0} });
+	DeltaStepping withZeroCycle(zeroCycle);
+	withZeroCycle.setThreadCount(4);
+	auto result = withZeroCycle.computeShortestPath(3, 0);
+	cout << "Shortest path from 3 to 0 over a zero-weight cycle: ";
+	for (int u : result.second) {
+		cout << u << " ";
+	}
+	cout << endl << "Length of the path: " << result.first << endl;
+}
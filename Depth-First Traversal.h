@@ -0,0 +1,186 @@
+/*
+Depth-first traversal with an explicit stack
+
+One DFS loop shared by the DFS-based algorithms of this repository. The stack
+holds (node, next out-edge) pairs instead of call frames, so a path of a million
+nodes is as safe as a path of ten.
+
+The algorithm plugs in as a visitor whose hooks the template calls directly, so
+the compiler inlines them and there is no virtual call per edge. Every hook
+returns true to go on or false to stop the whole traversal at once:
+
+	discover(u, parent)      u is reached for the first time, parent is NO_PARENT for a root
+	treeEdge(u, v)           v is unvisited and will be discovered from u
+	backEdge(u, v)           v is an ancestor of u that is still in progress
+	forwardOrCrossEdge(u, v) v is already finished
+	finish(u, parent)        all out-edges of u are done
+
+DfsVisitor provides hooks that do nothing, a visitor only redefines what it needs.
+PearceSccVisitor is the strongly connected components visitor shared by the SCC
+classes and the condensation of the transitive closure.
+*/
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "Compressed Sparse Row Graph.h"
+
+enum class DfsState : unsigned char { UNVISITED, IN_PROGRESS, FINISHED };
+
+struct DfsVisitor {
+	static constexpr int NO_PARENT = -1;
+
+	bool discover(int, int) { return true; }
+	bool treeEdge(int, int) { return true; }
+	bool backEdge(int, int) { return true; }
+	bool forwardOrCrossEdge(int, int) { return true; }
+	bool finish(int, int) { return true; }
+};
+
+class DepthFirstSearch {
+	CsrGraphView graph;
+	std::vector<DfsState> states;
+	// (node, position of the next out-edge to look at), root first
+	std::vector<std::pair<int, int>> stack;
+
+public:
+	explicit DepthFirstSearch(CsrGraphView _graph)
+		: graph{ _graph }
+		, states(_graph.size(), DfsState::UNVISITED) {}
+
+	// forget all visited nodes, also needed before reuse after a stopped traversal
+	void reset() {
+		states.assign(graph.size(), DfsState::UNVISITED);
+		stack.clear();
+	}
+
+	DfsState state(int u) const { return states[u]; }
+
+	// the nodes from the root down to the node whose edges are being scanned,
+	// e.g. to read off the cycle closed by a back edge
+	std::vector<int> currentPath() const {
+		std::vector<int> path;
+		path.reserve(stack.size());
+		for (auto& frame : stack) {
+			path.push_back(frame.first);
+		}
+		return path;
+	}
+
+	// traverse everything reachable from root that was not visited before;
+	// false if the visitor stopped the traversal
+	template <class Visitor>
+	bool run(int root, Visitor& visitor) {
+		if (states[root] != DfsState::UNVISITED) return true;
+
+		states[root] = DfsState::IN_PROGRESS;
+		if (!visitor.discover(root, DfsVisitor::NO_PARENT)) return false;
+		stack.push_back({ root, graph.edgeBegin(root) });
+
+		while (!stack.empty()) {
+			int u = stack.back().first;
+			int& edge = stack.back().second;
+
+			if (edge < graph.edgeEnd(u)) {
+				int v = graph.target(edge++);
+				bool proceed = true;
+				switch (states[v]) {
+					case DfsState::UNVISITED:
+						proceed = visitor.treeEdge(u, v);
+						if (proceed) {
+							states[v] = DfsState::IN_PROGRESS;
+							proceed = visitor.discover(v, u);
+							stack.push_back({ v, graph.edgeBegin(v) });
+						}
+						break;
+					case DfsState::IN_PROGRESS:
+						proceed = visitor.backEdge(u, v);
+						break;
+					case DfsState::FINISHED:
+						proceed = visitor.forwardOrCrossEdge(u, v);
+						break;
+				}
+				if (!proceed) return false;
+				continue;
+			}
+
+			states[u] = DfsState::FINISHED;
+			stack.pop_back();
+			int parent = stack.empty() ? DfsVisitor::NO_PARENT : stack.back().first;
+			if (!visitor.finish(u, parent)) return false;
+		}
+		return true;
+	}
+
+	// run from every unvisited node in increasing order
+	template <class Visitor>
+	bool runAll(Visitor& visitor) {
+		for (int u = 0; u < graph.size(); ++u) {
+			if (!run(u, visitor)) return false;
+		}
+		return true;
+	}
+};
+
+// Pearce's variant of Tarjan's algorithm. Components are numbered in the order
+// they are completed, so an edge between two components always leads from the
+// larger to the smaller id (sinks first)
+struct PearceSccVisitor : DfsVisitor {
+	// 0: unvisited, 1..: DFS index while open, then n - 1 - component id.
+	// Component ids count down from n - 1 and always stay above the open
+	// indices, so finished nodes never lower the rindex of an open one
+	std::vector<int> rindex;
+	std::vector<bool> isRoot;
+	// open nodes that are not the root of their component yet
+	std::vector<int> stack;
+	int index = 1;
+	int nextComponent;
+
+	explicit PearceSccVisitor(int n)
+		: rindex(n, 0)
+		, isRoot(n, false)
+		, nextComponent{ n - 1 } {}
+
+	// the edge u -> v is done
+	bool finishEdge(int u, int v) {
+		if (rindex[v] < rindex[u]) {
+			rindex[u] = rindex[v];
+			isRoot[u] = false;
+		}
+		return true;
+	}
+
+	bool discover(int u, int) {
+		isRoot[u] = true;
+		rindex[u] = index++;
+		return true;
+	}
+
+	bool backEdge(int u, int v) { return finishEdge(u, v); }
+	bool forwardOrCrossEdge(int u, int v) { return finishEdge(u, v); }
+
+	bool finish(int u, int parent) {
+		if (isRoot[u]) {
+			// u and everything open above it form one component
+			index--;
+			while (!stack.empty() && rindex[u] <= rindex[stack.back()]) {
+				rindex[stack.back()] = nextComponent;
+				stack.pop_back();
+				index--;
+			}
+			rindex[u] = nextComponent--;
+		}
+		else {
+			stack.push_back(u);
+		}
+
+		// the tree edge parent -> u is done
+		return parent == NO_PARENT || finishEdge(parent, u);
+	}
+
+	// only valid once every node is finished
+	int componentCount() const { return static_cast<int>(rindex.size()) - 1 - nextComponent; }
+	int componentOf(int u) const { return static_cast<int>(rindex.size()) - 1 - rindex[u]; }
+};
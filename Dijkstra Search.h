@@ -0,0 +1,145 @@
+/*
+Dijkstra search with reusable scratch space
+
+The search loop and its per-thread state, shared by Dijkstra's queries and the
+per-source searches of Johnson's algorithm. SearchState keeps distances, parents
+and one queue of every kind from Priority Queues.h; dijkstraSearch() runs one
+search into it:
+
+	dijkstraSearch<IndexedDaryHeap<4>>(graph, state, start, target);
+	state.distance(v), state.parent(v)
+
+A search only reads the weights through the CsrGraphView, so a view of the same
+edges with other weights (see CsrGraphView::withWeights) searches on those.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Priority Queues.h"
+
+// everything one query writes, reused by the next query on the same thread.
+// Entries only count when their stamp matches the current epoch, so starting
+// a query is O(1) instead of re-filling arrays of size V
+class SearchState {
+	std::vector<int> distances;
+	std::vector<int> parents;
+	std::vector<unsigned> reached;
+	std::vector<unsigned> settled;
+	unsigned epoch = 0;
+	int nodeCount;
+	int settledCount = 0;
+
+	// created on first use, they reset themselves while being emptied
+	std::unique_ptr<LazyBinaryHeap> binaryHeap;
+	std::unique_ptr<IndexedDaryHeap<4>> daryHeap;
+	std::unique_ptr<PairingHeap> pairingHeap;
+	std::unique_ptr<RadixHeap> radixHeap;
+
+	template <class Queue>
+	Queue& lazily(std::unique_ptr<Queue>& queue) {
+		if (!queue) {
+			queue.reset(new Queue(nodeCount));
+		}
+		return *queue;
+	}
+
+public:
+	// distance and parent of nodes the current query has not reached
+	static constexpr int UNKNOWN = -1;
+
+	explicit SearchState(int n)
+		: distances(n)
+		, parents(n)
+		, reached(n, 0)
+		, settled(n, 0)
+		, nodeCount{ n } {}
+
+	void begin() {
+		// on wrap-around the stamps of old queries could look current again
+		if (++epoch == 0) {
+			std::fill(reached.begin(), reached.end(), 0);
+			std::fill(settled.begin(), settled.end(), 0);
+			epoch = 1;
+		}
+		settledCount = 0;
+	}
+
+	int distance(int v) const { return reached[v] == epoch ? distances[v] : UNKNOWN; }
+	int parent(int v) const { return reached[v] == epoch ? parents[v] : UNKNOWN; }
+	bool isSettled(int v) const { return settled[v] == epoch; }
+
+	void reach(int v, int distance, int parent) {
+		reached[v] = epoch;
+		distances[v] = distance;
+		parents[v] = parent;
+	}
+
+	void settle(int v) {
+		settled[v] = epoch;
+		settledCount++;
+	}
+
+	// nodes settled by the current query, the usual measure of search effort
+	int getSettledCount() const { return settledCount; }
+
+	LazyBinaryHeap& queue(LazyBinaryHeap*) { return lazily(binaryHeap); }
+	IndexedDaryHeap<4>& queue(IndexedDaryHeap<4>*) { return lazily(daryHeap); }
+	PairingHeap& queue(PairingHeap*) { return lazily(pairingHeap); }
+	RadixHeap& queue(RadixHeap*) { return lazily(radixHeap); }
+};
+
+// Dijkstra on the keys distance + heuristic(v), which is A* when the heuristic is a
+// consistent lower bound; with heuristic 0 this is the plain algorithm. Stops once
+// target is settled, SearchState::UNKNOWN runs to exhaustion
+template <class Queue, class Heuristic>
+void dijkstraSearch(CsrGraphView graph, SearchState& scratch, int start, int target, Heuristic heuristic) {
+	Queue& distanceQueue = scratch.queue(static_cast<Queue*>(nullptr));
+
+	// forget the previous query
+	scratch.begin();
+
+	// handle the starting node
+	distanceQueue.update(start, heuristic(start));
+	scratch.reach(start, 0, start);
+
+	// BFS:
+	while (!distanceQueue.empty()) {
+		// get the closest node from the queue
+		int u = distanceQueue.pop().first;
+
+		// do not visit a node more than once, lazy queues hold stale duplicates
+		if (scratch.isSettled(u)) continue;
+
+		scratch.settle(u);
+
+		// the distance of a settled node is final
+		if (u == target) break;
+
+		int distance = scratch.distance(u);
+		for (int e = graph.edgeBegin(u); e < graph.edgeEnd(u); ++e) {
+			int v = graph.target(e),
+				weight = graph.weight(e);
+
+			// relax the edge (u, v)
+			if (scratch.distance(v) == SearchState::UNKNOWN
+				or scratch.distance(v) > distance + weight) {
+
+				scratch.reach(v, distance + weight, u);
+				distanceQueue.update(v, distance + weight + heuristic(v));
+			}
+		}
+	}
+
+	// an early exit leaves entries behind
+	distanceQueue.clear();
+}
+
+template <class Queue>
+void dijkstraSearch(CsrGraphView graph, SearchState& scratch, int start, int target = SearchState::UNKNOWN) {
+	dijkstraSearch<Queue>(graph, scratch, start, target, [](int) { return 0; });
+}
@@ -11,6 +11,22 @@ Thus, the time complexity of Dijkstra can be given as O(∣E∣log∣V∣)
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <fstream>
+#include <string>
+#include <random>
+#include <climits>
+#include <cstdio>
+#include <iterator>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Dijkstra Search.h"
+#include "Edge List Loader.h"
+#include "Priority Queues.h"
+#include "Thread Pool.h"
+
 using namespace std;
 
 namespace {
@@ -27,88 +43,408 @@ namespace {
 
 	const int UNKNOWN = -1;
 
+	// priority queue used by a query, see Priority Queues.h
+	enum class QueueType {
+		// std::priority_queue with duplicate entries instead of decrease-key
+		BINARY_HEAP,
+		// indexed 4-ary heap with decrease-key
+		D_ARY_HEAP,
+		PAIRING_HEAP,
+		// monotone radix heap, best for small integer weights
+		RADIX_HEAP
+	};
+
+	// how computeLandmarks picks the landmarks
+	enum class LandmarkSelection {
+		// each new landmark is the node farthest from the ones picked so far
+		FARTHEST,
+		// Goldberg and Werneck: grow a shortest path tree from a random root and
+		// pick a leaf in the region the current landmarks cover worst
+		AVOID
+	};
+
+	// precomputed distances from and to a few landmarks (ALT). By the triangle
+	// inequality they give lower bounds on the distance between any two nodes.
+	// Node-major layout: the values for node v are at [v * k, v * k + k)
+	class LandmarkTable {
+		int nodeCount = 0;
+		vector<int> landmarks;
+		// d(landmark, v) and d(v, landmark), UNKNOWN when there is no path
+		vector<int> fromLandmark;
+		vector<int> toLandmark;
+
+		static constexpr char MAGIC[4] = { 'A', 'L', 'T', '1' };
+
+	public:
+		LandmarkTable() = default;
+
+		LandmarkTable(int _nodeCount, vector<int> _landmarks, vector<int> _fromLandmark, vector<int> _toLandmark)
+			: nodeCount{ _nodeCount }
+			, landmarks(move(_landmarks))
+			, fromLandmark(move(_fromLandmark))
+			, toLandmark(move(_toLandmark)) {}
+
+		int size() const { return static_cast<int>(landmarks.size()); }
+		int getNodeCount() const { return nodeCount; }
+		const vector<int>& getLandmarks() const { return landmarks; }
+
+		// max over all landmarks L of d(L, t) - d(L, v) and d(v, L) - d(t, L)
+		int lowerBound(int v, int t) const {
+			return lowerBound(fromLandmark.data(), toLandmark.data(), size(), size(), v, t);
+		}
+
+		// the same bound over the first k columns of rows that are stride wide,
+		// used while the table is still being filled
+		static int lowerBound(const int* fromLandmark, const int* toLandmark, int stride, int k, int v, int t) {
+			const int* fromV = fromLandmark + size_t(v) * stride;
+			const int* fromT = fromLandmark + size_t(t) * stride;
+			const int* toV = toLandmark + size_t(v) * stride;
+			const int* toT = toLandmark + size_t(t) * stride;
+
+			int bound = 0;
+			for (int i = 0; i < k; ++i) {
+				if (fromV[i] != UNKNOWN && fromT[i] != UNKNOWN) {
+					bound = max(bound, fromT[i] - fromV[i]);
+				}
+				if (toV[i] != UNKNOWN && toT[i] != UNKNOWN) {
+					bound = max(bound, toV[i] - toT[i]);
+				}
+			}
+			return bound;
+		}
+
+		void save(const string& fileName) const {
+			ofstream out(fileName, ios::binary);
+			int k = size();
+			out.write(MAGIC, sizeof(MAGIC));
+			out.write(reinterpret_cast<const char*>(&nodeCount), sizeof(nodeCount));
+			out.write(reinterpret_cast<const char*>(&k), sizeof(k));
+			out.write(reinterpret_cast<const char*>(landmarks.data()), sizeof(int) * landmarks.size());
+			out.write(reinterpret_cast<const char*>(fromLandmark.data()), sizeof(int) * fromLandmark.size());
+			out.write(reinterpret_cast<const char*>(toLandmark.data()), sizeof(int) * toLandmark.size());
+			if (!out) {
+				throw runtime_error("Could not write the landmark table to " + fileName);
+			}
+		}
+
+		static LandmarkTable load(const string& fileName) {
+			ifstream in(fileName, ios::binary | ios::ate);
+			// the arrays cannot be longer than the rest of the file
+			long long remaining = in ? static_cast<long long>(in.tellg()) : 0;
+			in.seekg(0);
+			char magic[4] = {};
+			int n = 0, k = 0;
+			in.read(magic, sizeof(magic));
+			in.read(reinterpret_cast<char*>(&n), sizeof(n));
+			in.read(reinterpret_cast<char*>(&k), sizeof(k));
+			if (!in || !equal(magic, magic + 4, MAGIC) || n < 0 || k < 0) {
+				throw runtime_error("Not a landmark table: " + fileName);
+			}
+			// k landmarks and two n x k tables, at most 2^63 - 1 ints for any n and k
+			long long cells = static_cast<long long>(k) + 2 * static_cast<long long>(n) * k;
+			if (cells > remaining / static_cast<long long>(sizeof(int))) {
+				throw runtime_error("Truncated landmark table: " + fileName);
+			}
+
+			vector<int> landmarks(k), fromLandmark(size_t(n) * k), toLandmark(size_t(n) * k);
+			in.read(reinterpret_cast<char*>(landmarks.data()), sizeof(int) * landmarks.size());
+			in.read(reinterpret_cast<char*>(fromLandmark.data()), sizeof(int) * fromLandmark.size());
+			in.read(reinterpret_cast<char*>(toLandmark.data()), sizeof(int) * toLandmark.size());
+			if (!in) {
+				throw runtime_error("Truncated landmark table: " + fileName);
+			}
+			// distances are UNKNOWN or non-negative, so lowerBound cannot overflow
+			bool corrupt = any_of(landmarks.begin(), landmarks.end(), [&](int v) { return v < 0 || v >= n; });
+			for (const vector<int>* table : { &fromLandmark, &toLandmark }) {
+				corrupt = corrupt || any_of(table->begin(), table->end(), [](int d) { return d < UNKNOWN; });
+			}
+			if (corrupt) {
+				throw runtime_error("Corrupt landmark table: " + fileName);
+			}
+			return LandmarkTable(n, move(landmarks), move(fromLandmark), move(toLandmark));
+		}
+	};
+
+	// query engine: the graph is loaded once and any number of queries can be
+	// run against it, one at a time or as a batch spread over worker threads
 	class Dijkstra {
-		AdjacencyList adjacencyList;
-		vector<int> distances;
-		vector<int> parents;
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
+
+		// state of the last single query
+		SearchState state;
+
+		// batch queries: one scratch state per worker, both created on first use
+		int threadCount = 0;
+		shared_ptr<ThreadPool> threadPool;
+		vector<SearchState> workerStates;
 		
 	public:
-		Dijkstra(AdjacencyList& _adjacencyList)
-			: adjacencyList{ _adjacencyList }
-			, distances { vector<int>(_adjacencyList.size(), UNKNOWN) }
-			, parents { vector<int>(_adjacencyList.size(), UNKNOWN) }
+		Dijkstra(const AdjacencyList& _adjacencyList)
+			: ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+			, graph{ ownedGraph->view() }
+			, state(graph.size())
+		{}
+
+		// zero-copy: the caller keeps the weighted CsrGraph alive,
+		// throws invalid_argument if it has no weights
+		Dijkstra(CsrGraphView _graph)
+			: graph{ requireWeights(_graph) }
+			, state(graph.size())
 		{}
 
 
-		// return both the length of the shortest path and the path itself
-		pair<int, vector<int>> computeShortestPath(int start, int end) {
-			runDijkstra(start);
+		// return both the length of the shortest path and the path itself;
+		// with stopAtTarget the search ends as soon as end is settled
+		pair<int, vector<int>> computeShortestPath(int start, int end,
+			QueueType queueType = QueueType::BINARY_HEAP, bool stopAtTarget = false) {
+			runDijkstra(start, queueType, stopAtTarget ? end : UNKNOWN);
 
-			if (distances[end] == UNKNOWN) {
+			if (state.distance(end) == UNKNOWN) {
 				throw NoPathExistsException();
 			}
 
+			return { state.distance(end), reconstructPath(state, start, end) };
+		}
+		
+		
+		// A* query guided by landmark lower bounds, settles far fewer nodes than
+		// plain Dijkstra on road-like graphs and returns the same result
+		pair<int, vector<int>> computeShortestPath(int start, int end,
+			const LandmarkTable& landmarks, QueueType queueType = QueueType::BINARY_HEAP) {
+			if (landmarks.getNodeCount() != graph.size()) {
+				throw invalid_argument("The landmark table belongs to another graph.");
+			}
+
+			auto heuristic = [&](int v) { return landmarks.lowerBound(v, end); };
+			switch (queueType) {
+				case QueueType::BINARY_HEAP: search<LazyBinaryHeap>(state, start, end, heuristic); break;
+				case QueueType::D_ARY_HEAP: search<IndexedDaryHeap<4>>(state, start, end, heuristic); break;
+				case QueueType::PAIRING_HEAP: search<PairingHeap>(state, start, end, heuristic); break;
+				case QueueType::RADIX_HEAP: search<RadixHeap>(state, start, end, heuristic); break;
+			}
+
+			if (state.distance(end) == UNKNOWN) {
+				throw NoPathExistsException();
+			}
+
+			return { state.distance(end), reconstructPath(state, start, end) };
+		}
+		
+		// target: stop once this node is settled, UNKNOWN runs to exhaustion
+		void runDijkstra(int start, QueueType queueType = QueueType::BINARY_HEAP, int target = UNKNOWN) {
+			search(state, start, target, queueType);
+		}
+
+		// nodes settled by the last single query
+		int getSettledCount() const { return state.getSettledCount(); }
+
+		// offline preprocessing for the A* queries: two full searches per landmark,
+		// one on the graph and one on its transpose
+		LandmarkTable computeLandmarks(int count, LandmarkSelection selection = LandmarkSelection::AVOID,
+			unsigned seed = 0) {
+			int n = graph.size();
+			count = min(count, n);
+
+			CsrGraph transposed = CsrGraph::transposeOf(graph);
+			Dijkstra backward(transposed);
+
+			vector<int> landmarks;
+			vector<int> fromLandmark(size_t(n) * count, UNKNOWN);
+			vector<int> toLandmark(size_t(n) * count, UNKNOWN);
+			vector<bool> isLandmark(n, false);
+			mt19937 random(seed);
+
+			for (int i = 0; i < count; ++i) {
+				int landmark = selection == LandmarkSelection::FARTHEST
+					? farthestLandmark(landmarks, fromLandmark, count, isLandmark, random)
+					: avoidLandmark(fromLandmark, toLandmark, count, i, isLandmark, random);
+
+				landmarks.push_back(landmark);
+				isLandmark[landmark] = true;
+
+				runDijkstra(landmark);
+				backward.runDijkstra(landmark);
+				for (int v = 0; v < n; ++v) {
+					fromLandmark[size_t(v) * count + i] = state.distance(v);
+					toLandmark[size_t(v) * count + i] = backward.getDistance(v);
+				}
+			}
+
+			return LandmarkTable(n, move(landmarks), move(fromLandmark), move(toLandmark));
+		}
+
+		// results of the last runDijkstra, UNKNOWN for nodes it did not reach
+		int getDistance(int v) const { return state.distance(v); }
+		int getParent(int v) const { return state.parent(v); }
+
+		vector<int> getDistances() const {
+			vector<int> distances(graph.size());
+			for (int v = 0; v < graph.size(); ++v) {
+				distances[v] = state.distance(v);
+			}
+			return distances;
+		}
+
+		// 0 uses one thread per hardware thread
+		void setThreadCount(int _threadCount) {
+			threadCount = _threadCount;
+			threadPool.reset();
+			workerStates.clear();
+		}
+
+		// answers every (start, end) query with a search that stops at its target;
+		// unreachable targets give { UNKNOWN, {} } instead of throwing
+		vector<pair<int, vector<int>>> computeShortestPaths(
+			const vector<pair<int, int>>& queries, QueueType queueType = QueueType::BINARY_HEAP) {
+			if (!threadPool) {
+				threadPool = make_shared<ThreadPool>(threadCount);
+			}
+			while (workerStates.size() < size_t(threadPool->size())) {
+				workerStates.emplace_back(graph.size());
+			}
+
+			vector<pair<int, vector<int>>> results(queries.size(), { UNKNOWN, vector<int>() });
+			threadPool->parallelFor(queries.size(), 1, [&](int worker, size_t begin, size_t end) {
+				SearchState& scratch = workerStates[worker];
+				for (size_t i = begin; i < end; ++i) {
+					int start = queries[i].first, target = queries[i].second;
+					search(scratch, start, target, queueType);
+					if (scratch.distance(target) != UNKNOWN) {
+						results[i] = { scratch.distance(target), reconstructPath(scratch, start, target) };
+					}
+				}
+			});
+			return results;
+		}
+
+	private:
+		static vector<int> reconstructPath(const SearchState& scratch, int start, int end) {
 			// reconstruct the path from parents
 			vector<int> path;
 			path.push_back(end);
 			int current = end;
 			while (current != start) {
-				current = parents[current];
+				current = scratch.parent(current);
 				path.push_back(current);
 			}
 
 			reverse(path.begin(), path.end());
-			return { distances[end] , path };
+			return path;
 		}
-		
-		
-		void runDijkstra(int start) {
-			auto comparator = [](const NodeAndDistance& p1, const NodeAndDistance& p2) {
-				return p1.second > p2.second 
-					or (p1.second == p2.second
-						&& p1.first > p2.first);
-			};
-
-			priority_queue<
-				NodeAndDistance,
-				vector<NodeAndDistance>,
-				decltype(comparator)> distanceQueue(comparator);
-
-			vector<bool> visited(adjacencyList.size(), false);
-
-			// handle the starting node
-			distanceQueue.push({start, 0});
-			parents[start];
-			distances[start] = 0;
-
-			// BFS:
-			while (!distanceQueue.empty()) {
-				// get the closest node from the queue
-				auto& current = distanceQueue.top();
-				distanceQueue.pop();
-
-				int u = current.first;
-				int distance = current.second;
-
-				// do not visit a node more than once
-				if (visited[u]) continue;
-
-				visited[u] = true;
-
-				for (auto& neibhor : adjacencyList[u]) {
-					int v = neibhor.first, 
-						weight = neibhor.second;
-
-					// relax the edge (u, v)
-					if (distances[v] == UNKNOWN 
-						or distances[v] > distances[u] + weight) {
-
-						parents[v] = u;
-						distances[v] = distances[u] + weight;
-						distanceQueue.push({ v, distances[v] });
-					}
+
+		void search(SearchState& scratch, int start, int target, QueueType queueType) const {
+			switch (queueType) {
+				case QueueType::BINARY_HEAP: search<LazyBinaryHeap>(scratch, start, target); break;
+				case QueueType::D_ARY_HEAP: search<IndexedDaryHeap<4>>(scratch, start, target); break;
+				case QueueType::PAIRING_HEAP: search<PairingHeap>(scratch, start, target); break;
+				case QueueType::RADIX_HEAP: search<RadixHeap>(scratch, start, target); break;
+			}
+		}
+
+		int farthestLandmark(const vector<int>& landmarks, const vector<int>& fromLandmark, int stride,
+			const vector<bool>& isLandmark, mt19937& random) {
+			int n = graph.size();
+			if (landmarks.empty()) {
+				// the node farthest from a random start
+				runDijkstra(random() % n);
+				int farthest = 0;
+				for (int v = 1; v < n; ++v) {
+					if (state.distance(v) > state.distance(farthest)) farthest = v;
+				}
+				return farthest;
+			}
+
+			// maximize the distance to the closest landmark, unreachable nodes count
+			// as infinitely far so that every component eventually gets a landmark
+			int best = UNKNOWN;
+			long long bestDistance = -1;
+			for (int v = 0; v < n; ++v) {
+				if (isLandmark[v]) continue;
+				long long closest = LLONG_MAX;
+				for (size_t i = 0; i < landmarks.size(); ++i) {
+					int d = fromLandmark[size_t(v) * stride + i];
+					if (d != UNKNOWN) closest = min<long long>(closest, d);
+				}
+				if (closest > bestDistance) {
+					bestDistance = closest;
+					best = v;
 				}
 			}
+			return best;
+		}
+
+		int avoidLandmark(const vector<int>& fromLandmark, const vector<int>& toLandmark, int stride, int picked,
+			const vector<bool>& isLandmark, mt19937& random) {
+			int n = graph.size();
+
+			// shortest path tree from a random root
+			int root = random() % n;
+			runDijkstra(root);
+
+			// children of every tree node in CSR form, and the tree nodes by distance
+			vector<int> order;
+			vector<int> childOffsets(n + 1, 0);
+			for (int v = 0; v < n; ++v) {
+				if (state.distance(v) == UNKNOWN) continue;
+				order.push_back(v);
+				if (v != root) childOffsets[state.parent(v) + 1]++;
+			}
+			for (int v = 0; v < n; ++v) {
+				childOffsets[v + 1] += childOffsets[v];
+			}
+			vector<int> children(childOffsets[n]);
+			vector<int> position(childOffsets.begin(), childOffsets.end() - 1);
+			for (int v : order) {
+				if (v != root) children[position[state.parent(v)]++] = v;
+			}
+			sort(order.begin(), order.end(), [&](int a, int b) { return state.distance(a) > state.distance(b); });
+
+			// weight: how much the current landmarks underestimate d(root, v);
+			// size: total weight of the subtree, 0 if the subtree already holds a landmark
+			vector<long long> size(n, 0);
+			vector<bool> coversLandmark(n, false);
+			for (int v : order) {
+				size[v] += state.distance(v)
+					- LandmarkTable::lowerBound(fromLandmark.data(), toLandmark.data(), stride, picked, root, v);
+				coversLandmark[v] = coversLandmark[v] || isLandmark[v];
+				if (coversLandmark[v]) size[v] = 0;
+				if (v != root) {
+					int parent = state.parent(v);
+					size[parent] += size[v];
+					coversLandmark[parent] = coversLandmark[parent] || coversLandmark[v];
+				}
+			}
+
+			// start at the heaviest node and follow the heaviest child down to a leaf
+			int node = order.empty() ? root : *max_element(order.begin(), order.end(),
+				[&](int a, int b) { return size[a] < size[b]; });
+			if (size[node] == 0) {
+				// everything reachable is covered, fall back to any free node
+				for (int v = 0; v < n; ++v) {
+					if (!isLandmark[v]) return v;
+				}
+			}
+			while (childOffsets[node] < childOffsets[node + 1]) {
+				int heaviest = children[childOffsets[node]];
+				for (int c = childOffsets[node]; c < childOffsets[node + 1]; ++c) {
+					if (size[children[c]] > size[heaviest]) heaviest = children[c];
+				}
+				if (size[heaviest] == 0) break;
+				node = heaviest;
+			}
+			return node;
+		}
+
+		template <class Queue>
+		void search(SearchState& scratch, int start, int target) const {
+			dijkstraSearch<Queue>(graph, scratch, start, target);
+		}
+
+		template <class Queue, class Heuristic>
+		void search(SearchState& scratch, int start, int target, Heuristic heuristic) const {
+			dijkstraSearch<Queue>(graph, scratch, start, target, heuristic);
 		}
 	};
 }
@@ -141,4 +477,134 @@ void testDijkstra() {
 		cout << u << " ";
 	}
 	cout << endl << "Length of the path: " << distance << endl;
+
+	for (QueueType queueType : { QueueType::D_ARY_HEAP, QueueType::PAIRING_HEAP, QueueType::RADIX_HEAP }) {
+		auto early = dijkstra.computeShortestPath(0, 2, queueType, true);
+		cout << "Length of the path with early exit: " << early.first << endl;
+	}
+
+	// the same engine answers a whole batch, spread over worker threads
+	dijkstra.setThreadCount(2);
+	auto batch = dijkstra.computeShortestPaths({ {0, 2}, {3, 2}, {2, 0}, {1, 4} }, QueueType::D_ARY_HEAP);
+	cout << "Batched path lengths:";
+	for (auto& answer : batch) {
+		cout << " " << answer.first;
+	}
+	cout << endl;
+
+	// goal-directed A* queries with landmark lower bounds
+	LandmarkTable landmarks = dijkstra.computeLandmarks(2, LandmarkSelection::AVOID);
+	auto alt = dijkstra.computeShortestPath(0, 2, landmarks);
+	cout << "Length of the path with landmarks: " << alt.first
+		<< ", settled nodes: " << dijkstra.getSettledCount() << endl;
+
+	// the table is computed once and stored, queries use the loaded copy
+	string tableName = "landmark_table_test.alt";
+	landmarks.save(tableName);
+	LandmarkTable loadedLandmarks = LandmarkTable::load(tableName);
+	cout << "Same path with the loaded landmarks: "
+		<< (dijkstra.computeShortestPath(0, 2, loadedLandmarks) == alt) << endl;
+
+	// a file cut short must be rejected instead of read out of bounds
+	{
+		ifstream in(tableName, ios::binary);
+		string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+		in.close();
+		ofstream out(tableName, ios::binary | ios::trunc);
+		out.write(bytes.data(), bytes.size() - sizeof(int));
+	}
+	try {
+		LandmarkTable::load(tableName);
+	}
+	catch (runtime_error exc) {
+		cout << "Truncated landmark table rejected." << endl;
+	}
+	remove(tableName.c_str());
+
+	// the same graph as a DIMACS .gr text, which numbers the nodes from 1
+	string text = "p sp 5 9\n";
+	for (auto& edge : edges) {
+		text += "a " + to_string(edge[0] + 1) + " " + to_string(edge[1] + 1) + " " + to_string(edge[2]) + "\n";
+	}
+	EdgeListLoader loader(EdgeListFormat::DIMACS);
+	loader.setThreadCount(2);
+	CsrGraph loaded = loader.parse(text);
+	Dijkstra fromLoader(loaded);
+	cout << "Length of the path in the loaded graph: " << fromLoader.computeShortestPath(0, 2).first << endl;
+
+	// the same text from a file goes through the memory-mapped path
+	string fileName = "edge_list_loader_test.gr";
+	{
+		ofstream out(fileName, ios::binary);
+		out << text;
+	}
+	CsrGraph mapped = loader.load(fileName);
+	cout << "Length of the path in the mapped file: " << Dijkstra(mapped).computeShortestPath(0, 2).first << endl;
+	remove(fileName.c_str());
+
+	// SNAP with a repeated edge: 0 -> 1 kept once with the smaller weight,
+	// symmetrize adds 1 -> 0, 2 -> 1 and 0 -> 2
+	EdgeListLoader snap(EdgeListFormat::SNAP);
+	snap.setWeighted(true);
+	snap.setSymmetrize(true);
+	snap.setDeduplicate(true);
+	CsrGraph snapGraph = snap.parse("# from to weight\n0 1 7\n0 1 3\n1 2 4\n2 0\n");
+	cout << "SNAP edges after symmetrize and deduplicate: " << snapGraph.edgeCount()
+		<< ", d(1, 0) = " << Dijkstra(snapGraph).computeShortestPath(1, 0).first << endl;
+
+	// a symmetric real Matrix Market file stores only one triangle
+	EdgeListLoader matrixMarket(EdgeListFormat::MATRIX_MARKET);
+	CsrGraph mmGraph = matrixMarket.parse(
+		"%%MatrixMarket matrix coordinate real symmetric\n% lower triangle\n3 3 2\n2 1 1.5\n3 2 2.4\n");
+	cout << "Matrix Market edges: " << mmGraph.edgeCount()
+		<< ", d(0, 2) = " << Dijkstra(mmGraph).computeShortestPath(0, 2).first << endl;
+	CsrGraph pattern = matrixMarket.parse("%%MatrixMarket matrix coordinate pattern general\n2 2 2\n1 2\n1 2\n");
+	cout << "Pattern entries are unweighted: " << !pattern.isWeighted() << ", edges: " << pattern.edgeCount() << endl;
+
+	// a ring spread over several chunks, listed twice so that duplicates meet
+	// only after the chunks are merged
+	int ring = 20000;
+	string ringText;
+	for (int pass = 0; pass < 2; ++pass) {
+		for (int u = 0; u < ring; ++u) {
+			ringText += to_string(u) + " " + to_string((u + 1) % ring) + "\n";
+		}
+	}
+	EdgeListLoader ringLoader(EdgeListFormat::SNAP);
+	ringLoader.setThreadCount(2);
+	ringLoader.setDeduplicate(true);
+	CsrGraph ringGraph = ringLoader.parse(ringText);
+	bool ringIntact = ringGraph.size() == ring && ringGraph.edgeCount() == ring;
+	for (int u = 0; u < ringGraph.size() && ringIntact; ++u) {
+		ringIntact = ringGraph.view().degree(u) == 1 && *ringGraph.view().neighbors(u).begin() == (u + 1) % ring;
+	}
+	cout << "Ring of " << ringText.size() << " bytes loaded intact: " << ringIntact << endl;
+
+	// malformed input is reported, not read out of bounds
+	for (string bad : { "p sp -5 2\n", "p max 2 1\na 1 2 3\n", "p sp 2 1\na 1 3 4\n", "p sp 2 1\na 1\n" }) {
+		try {
+			loader.parse(bad);
+		}
+		catch (MalformedEdgeListException exc) {
+			cout << "Rejected: " << exc.what() << endl;
+		}
+	}
+	try {
+		matrixMarket.parse("%%MatrixMarket matrix coordinate pattern general\n-3 3 1\n1 2\n");
+	}
+	catch (MalformedEdgeListException exc) {
+		cout << "Rejected: " << exc.what() << endl;
+	}
+	try {
+		snap.parse("0 2147483647\n");
+	}
+	catch (MalformedEdgeListException exc) {
+		cout << "Rejected: " << exc.what() << endl;
+	}
+	try {
+		loader.load("no_such_file.gr");
+	}
+	catch (CannotReadFileException exc) {
+		cout << "Rejected: " << exc.what() << endl;
+	}
 }
\ No newline at end of file
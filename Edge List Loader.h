@@ -0,0 +1,556 @@
+/*
+Edge list loader
+
+Reads a text edge list straight into a CsrGraph, which every algorithm class of
+this repository accepts as a CsrGraphView. Supported formats:
+	SNAP            "u v" or "u v w" per line, 0-based ids, '#' comments
+	MATRIX_MARKET   coordinate format, "%%MatrixMarket matrix coordinate <field> <symmetry>"
+	                banner, "rows cols entries" size line, then "i j [value]", 1-based ids
+	DIMACS          9th DIMACS challenge .gr files: "p sp n m" and "a u v w", 1-based ids
+
+The file is memory-mapped, cut into chunks at line boundaries and every chunk is
+parsed by its own worker. The CSR arrays are then built without any per-node
+vector: the workers count the out-degrees, a prefix sum turns them into offsets and
+the workers scatter the edges into their slots. Every neighbor list is sorted
+afterwards, so the result does not depend on the thread timing.
+
+Optionally every edge is also added in the reverse direction (symmetrize), and
+repeated edges are dropped keeping the smallest weight (deduplicate).
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Compressed Sparse Row Graph.h"
+#include "Thread Pool.h"
+
+enum class EdgeListFormat { SNAP, MATRIX_MARKET, DIMACS };
+
+class MalformedEdgeListException : public std::runtime_error {
+public:
+	explicit MalformedEdgeListException(const std::string& reason)
+		: std::runtime_error("Malformed edge list: " + reason) {}
+};
+
+class CannotReadFileException : public std::runtime_error {
+public:
+	explicit CannotReadFileException(const std::string& path)
+		: std::runtime_error("Cannot read file " + path) {}
+};
+
+// read-only view of a whole file, memory-mapped where the platform allows it
+class MappedFile {
+	const char* data = nullptr;
+	size_t length = 0;
+	// fallback for platforms without mmap
+	std::vector<char> buffer;
+	bool mapped = false;
+
+public:
+	explicit MappedFile(const std::string& path) {
+#if !defined(_WIN32)
+		int descriptor = ::open(path.c_str(), O_RDONLY);
+		if (descriptor < 0) {
+			throw CannotReadFileException(path);
+		}
+		struct stat status;
+		if (::fstat(descriptor, &status) != 0) {
+			::close(descriptor);
+			throw CannotReadFileException(path);
+		}
+		length = static_cast<size_t>(status.st_size);
+		if (length > 0) {
+			void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (address == MAP_FAILED) {
+				::close(descriptor);
+				throw CannotReadFileException(path);
+			}
+			// the file is read front to back by each worker
+			::madvise(address, length, MADV_SEQUENTIAL);
+			data = static_cast<const char*>(address);
+			mapped = true;
+		}
+		::close(descriptor);
+#else
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			throw CannotReadFileException(path);
+		}
+		buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		data = buffer.data();
+		length = buffer.size();
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() {
+#if !defined(_WIN32)
+		if (mapped) {
+			::munmap(const_cast<char*>(data), length);
+		}
+#endif
+	}
+
+	const char* begin() const { return data; }
+	const char* end() const { return data + length; }
+	size_t size() const { return length; }
+};
+
+class EdgeListLoader {
+	EdgeListFormat format;
+	bool symmetrize = false;
+	bool deduplicate = false;
+	// SNAP only, the other formats say in their header whether there are weights
+	bool weightedSnap = false;
+
+	int threadCount = 0;
+	std::shared_ptr<ThreadPool> threadPool;
+
+	// chunks per worker, so that a slow chunk does not hold up the others
+	static constexpr size_t CHUNKS_PER_WORKER = 4;
+	static constexpr size_t MIN_CHUNK_BYTES = 1 << 16;
+
+	// what the header says, nodeCount stays -1 for SNAP until the ids are seen
+	struct Header {
+		const char* body = nullptr;
+		int nodeCount = -1;
+		bool weighted = false;
+		// Matrix Market "symmetric": only one triangle is stored
+		bool symmetric = false;
+		// Matrix Market "real": weights are rounded to the nearest int
+		bool realWeights = false;
+	};
+
+	// the edges parsed from one chunk, ids already 0-based
+	struct Chunk {
+		const char* begin;
+		const char* end;
+		std::vector<int> sources;
+		std::vector<int> targets;
+		std::vector<int> weights;
+		int maxId = -1;
+	};
+
+	ThreadPool& pool() {
+		if (!threadPool) {
+			threadPool = std::make_shared<ThreadPool>(threadCount);
+		}
+		return *threadPool;
+	}
+
+	static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+	static const char* skipBlanks(const char* p, const char* end) {
+		while (p < end && isBlank(*p)) ++p;
+		return p;
+	}
+
+	static const char* nextLine(const char* p, const char* end) {
+		const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		return newline ? newline + 1 : end;
+	}
+
+	// reads an integer at p and moves p behind it, false if there is none
+	static bool parseInteger(const char*& p, const char* end, long long& value) {
+		p = skipBlanks(p, end);
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			++p;
+		}
+		if (p == end || *p < '0' || *p > '9') return false;
+
+		long long result = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			result = result * 10 + (*p - '0');
+			if (result > INT_MAX) {
+				throw MalformedEdgeListException("number out of range");
+			}
+			++p;
+		}
+		value = negative ? -result : result;
+		return true;
+	}
+
+	// a decimal number with optional fraction and exponent, for Matrix Market "real" values
+	static bool parseReal(const char*& p, const char* end, double& value) {
+		p = skipBlanks(p, end);
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			++p;
+		}
+
+		double result = 0;
+		bool digits = false;
+		while (p < end && *p >= '0' && *p <= '9') {
+			result = result * 10 + (*p++ - '0');
+			digits = true;
+		}
+		if (p < end && *p == '.') {
+			double scale = 0.1;
+			for (++p; p < end && *p >= '0' && *p <= '9'; ++p, scale /= 10) {
+				result += (*p - '0') * scale;
+				digits = true;
+			}
+		}
+		if (!digits) return false;
+
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			++p;
+			long long exponent;
+			if (!parseInteger(p, end, exponent)) return false;
+			result *= std::pow(10.0, static_cast<double>(exponent));
+		}
+		value = negative ? -result : result;
+		return true;
+	}
+
+	static std::string lowercaseWord(const char*& p, const char* end) {
+		p = skipBlanks(p, end);
+		std::string word;
+		while (p < end && !isBlank(*p) && *p != '\n') {
+			word.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(*p++))));
+		}
+		return word;
+	}
+
+	// the banner and size line of Matrix Market and the problem line of DIMACS,
+	// read sequentially before the body is split between the workers
+	Header parseHeader(const char* begin, const char* end) const {
+		Header header;
+		header.body = begin;
+
+		if (format == EdgeListFormat::SNAP) {
+			header.weighted = weightedSnap;
+			return header;
+		}
+
+		if (format == EdgeListFormat::MATRIX_MARKET) {
+			const char* p = begin;
+			if (lowercaseWord(p, end) != "%%matrixmarket" || lowercaseWord(p, end) != "matrix"
+				|| lowercaseWord(p, end) != "coordinate") {
+				throw MalformedEdgeListException("expected a \"%%MatrixMarket matrix coordinate\" banner");
+			}
+			std::string field = lowercaseWord(p, end);
+			std::string symmetry = lowercaseWord(p, end);
+			if (field != "pattern" && field != "integer" && field != "real") {
+				throw MalformedEdgeListException("unsupported field " + field);
+			}
+			if (symmetry != "general" && symmetry != "symmetric") {
+				throw MalformedEdgeListException("unsupported symmetry " + symmetry);
+			}
+			header.weighted = field != "pattern";
+			header.realWeights = field == "real";
+			header.symmetric = symmetry == "symmetric";
+
+			// comments, then the size line
+			p = nextLine(p, end);
+			while (p < end) {
+				const char* line = skipBlanks(p, end);
+				if (line < end && *line != '%' && *line != '\n') break;
+				p = nextLine(p, end);
+			}
+			long long rows, columns, entries;
+			if (!parseInteger(p, end, rows) || !parseInteger(p, end, columns) || !parseInteger(p, end, entries)) {
+				throw MalformedEdgeListException("expected the \"rows columns entries\" size line");
+			}
+			if (rows < 0 || columns < 0 || entries < 0) {
+				throw MalformedEdgeListException("negative size in the \"rows columns entries\" line");
+			}
+			header.nodeCount = static_cast<int>(std::max(rows, columns));
+			header.body = nextLine(p, end);
+			return header;
+		}
+
+		// DIMACS: the problem line comes before the first arc
+		header.weighted = true;
+		for (const char* p = begin; p < end; p = nextLine(p, end)) {
+			const char* line = skipBlanks(p, end);
+			if (line < end && *line == 'p') {
+				const char* q = line + 1;
+				std::string problem = lowercaseWord(q, end);
+				long long nodes, arcs;
+				if (problem != "sp" || !parseInteger(q, end, nodes) || !parseInteger(q, end, arcs)
+					|| nodes < 0 || arcs < 0) {
+					throw MalformedEdgeListException("expected \"p sp <nodes> <arcs>\"");
+				}
+				header.nodeCount = static_cast<int>(nodes);
+				header.body = nextLine(q, end);
+				return header;
+			}
+			if (line < end && *line == 'a') break;
+		}
+		throw MalformedEdgeListException("missing problem line");
+	}
+
+	// one line of the body into chunk, comments and blank lines are skipped
+	void parseLine(const char* line, const char* end, const Header& header, Chunk& chunk) const {
+		const char* p = skipBlanks(line, end);
+		if (p == end || *p == '\n') return;
+
+		if (format == EdgeListFormat::DIMACS) {
+			if (*p != 'a') return;
+			++p;
+		}
+		else if (*p == '#' || *p == '%') {
+			return;
+		}
+
+		long long u, v;
+		if (!parseInteger(p, end, u) || !parseInteger(p, end, v)) {
+			const char* lineEnd = nextLine(line, end);
+			while (lineEnd > line && (lineEnd[-1] == '\n' || lineEnd[-1] == '\r')) --lineEnd;
+			throw MalformedEdgeListException("expected an edge in \"" + std::string(line, lineEnd) + "\"");
+		}
+		if (format != EdgeListFormat::SNAP) {
+			u--;
+			v--;
+		}
+		// INT_MAX itself is no id, the node count id + 1 would not fit in an int
+		if (u < 0 || v < 0 || u >= INT_MAX || v >= INT_MAX
+			|| (header.nodeCount >= 0 && (u >= header.nodeCount || v >= header.nodeCount))) {
+			throw MalformedEdgeListException("node id out of range");
+		}
+
+		int weight = 1;
+		if (header.weighted) {
+			if (header.realWeights) {
+				double real;
+				if (!parseReal(p, end, real)) {
+					throw MalformedEdgeListException("missing weight");
+				}
+				weight = static_cast<int>(std::lround(real));
+			}
+			else {
+				long long value;
+				// SNAP lines may leave out the weight
+				if (parseInteger(p, end, value)) {
+					weight = static_cast<int>(value);
+				}
+				else if (format != EdgeListFormat::SNAP) {
+					throw MalformedEdgeListException("missing weight");
+				}
+			}
+			chunk.weights.push_back(weight);
+		}
+
+		chunk.sources.push_back(static_cast<int>(u));
+		chunk.targets.push_back(static_cast<int>(v));
+		chunk.maxId = std::max(chunk.maxId, static_cast<int>(std::max(u, v)));
+	}
+
+	// chunk boundaries moved forward to the next line start
+	std::vector<Chunk> split(const char* begin, const char* end, int workers) const {
+		size_t bytes = end - begin;
+		size_t count = std::max<size_t>(1, std::min(workers * CHUNKS_PER_WORKER, bytes / MIN_CHUNK_BYTES));
+
+		std::vector<Chunk> chunks;
+		const char* start = begin;
+		for (size_t i = 1; i <= count && start < end; ++i) {
+			const char* stop = i == count ? end : std::max(start, begin + bytes * i / count);
+			if (stop < end && stop > start && *(stop - 1) != '\n') {
+				stop = nextLine(stop, end);
+			}
+			if (stop == start) continue;
+			chunks.push_back(Chunk{ start, stop, {}, {}, {}, -1 });
+			start = stop;
+		}
+		return chunks;
+	}
+
+	// count, prefix sum, scatter, then sort and deduplicate every neighbor list
+	CsrGraph build(std::vector<Chunk>& chunks, int nodeCount, bool weighted, bool mirror) {
+		ThreadPool& workers = pool();
+
+		std::unique_ptr<std::atomic<int>[]> degrees(new std::atomic<int>[nodeCount]);
+		workers.parallelFor(nodeCount, 4096, [&](int, size_t begin, size_t end) {
+			for (size_t u = begin; u < end; ++u) {
+				degrees[u].store(0, std::memory_order_relaxed);
+			}
+		});
+		workers.parallelFor(chunks.size(), 1, [&](int, size_t begin, size_t end) {
+			for (size_t c = begin; c < end; ++c) {
+				for (size_t e = 0; e < chunks[c].sources.size(); ++e) {
+					int u = chunks[c].sources[e];
+					int v = chunks[c].targets[e];
+					degrees[u].fetch_add(1, std::memory_order_relaxed);
+					if (mirror && u != v) {
+						degrees[v].fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			}
+		});
+
+		std::vector<int> offsets(nodeCount + 1, 0);
+		long long total = 0;
+		for (int u = 0; u < nodeCount; ++u) {
+			total += degrees[u].load(std::memory_order_relaxed);
+			if (total > INT_MAX) {
+				throw MalformedEdgeListException("too many edges");
+			}
+			offsets[u + 1] = static_cast<int>(total);
+		}
+
+		// the degrees become the next free slot of every node
+		workers.parallelFor(nodeCount, 4096, [&](int, size_t begin, size_t end) {
+			for (size_t u = begin; u < end; ++u) {
+				degrees[u].store(offsets[u], std::memory_order_relaxed);
+			}
+		});
+		std::vector<int> targets(total);
+		std::vector<int> weights(weighted ? total : 0);
+		workers.parallelFor(chunks.size(), 1, [&](int, size_t begin, size_t end) {
+			for (size_t c = begin; c < end; ++c) {
+				Chunk& chunk = chunks[c];
+				for (size_t e = 0; e < chunk.sources.size(); ++e) {
+					int u = chunk.sources[e];
+					int v = chunk.targets[e];
+					int slot = degrees[u].fetch_add(1, std::memory_order_relaxed);
+					targets[slot] = v;
+					if (weighted) weights[slot] = chunk.weights[e];
+					if (mirror && u != v) {
+						slot = degrees[v].fetch_add(1, std::memory_order_relaxed);
+						targets[slot] = u;
+						if (weighted) weights[slot] = chunk.weights[e];
+					}
+				}
+				// the parsed edges are not needed anymore
+				std::vector<int>().swap(chunk.sources);
+				std::vector<int>().swap(chunk.targets);
+				std::vector<int>().swap(chunk.weights);
+			}
+		});
+
+		// sort by (target, weight) and keep the unique prefix of every list
+		std::vector<int> kept(nodeCount, 0);
+		workers.parallelFor(nodeCount, 1024, [&](int, size_t begin, size_t end) {
+			std::vector<std::pair<int, int>> entries;
+			for (size_t u = begin; u < end; ++u) {
+				int first = offsets[u];
+				int last = offsets[u + 1];
+				int length = last - first;
+				if (!weighted) {
+					std::sort(targets.begin() + first, targets.begin() + last);
+					if (deduplicate) {
+						length = static_cast<int>(std::unique(targets.begin() + first, targets.begin() + last) - (targets.begin() + first));
+					}
+				}
+				else {
+					entries.clear();
+					for (int e = first; e < last; ++e) {
+						entries.push_back({ targets[e], weights[e] });
+					}
+					std::sort(entries.begin(), entries.end());
+					if (deduplicate) {
+						// the first of equal targets has the smallest weight
+						length = static_cast<int>(std::unique(entries.begin(), entries.end(),
+							[](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first == b.first; }) - entries.begin());
+					}
+					for (int i = 0; i < length; ++i) {
+						targets[first + i] = entries[i].first;
+						weights[first + i] = entries[i].second;
+					}
+				}
+				kept[u] = length;
+			}
+		});
+
+		if (!deduplicate) {
+			return CsrGraph(std::move(offsets), std::move(targets), std::move(weights), weighted);
+		}
+
+		// close the gaps left by the dropped duplicates
+		std::vector<int> compactOffsets(nodeCount + 1, 0);
+		for (int u = 0; u < nodeCount; ++u) {
+			compactOffsets[u + 1] = compactOffsets[u] + kept[u];
+		}
+		std::vector<int> compactTargets(compactOffsets.back());
+		std::vector<int> compactWeights(weighted ? compactOffsets.back() : 0);
+		workers.parallelFor(nodeCount, 4096, [&](int, size_t begin, size_t end) {
+			for (size_t u = begin; u < end; ++u) {
+				std::copy(targets.begin() + offsets[u], targets.begin() + offsets[u] + kept[u], compactTargets.begin() + compactOffsets[u]);
+				if (weighted) {
+					std::copy(weights.begin() + offsets[u], weights.begin() + offsets[u] + kept[u], compactWeights.begin() + compactOffsets[u]);
+				}
+			}
+		});
+		return CsrGraph(std::move(compactOffsets), std::move(compactTargets), std::move(compactWeights), weighted);
+	}
+
+public:
+	explicit EdgeListLoader(EdgeListFormat _format)
+		: format{ _format } {}
+
+	// also add v -> u for every edge u -> v; Matrix Market "symmetric" files are always mirrored
+	void setSymmetrize(bool _symmetrize) { symmetrize = _symmetrize; }
+
+	// keep only one of several u -> v edges, the one with the smallest weight
+	void setDeduplicate(bool _deduplicate) { deduplicate = _deduplicate; }
+
+	// read a third column as the edge weight, 1 where it is missing
+	void setWeighted(bool _weighted) { weightedSnap = _weighted; }
+
+	// 0 uses one thread per hardware thread
+	void setThreadCount(int _threadCount) {
+		threadCount = _threadCount;
+		threadPool.reset();
+	}
+
+	// throws CannotReadFileException and MalformedEdgeListException
+	CsrGraph load(const std::string& path) {
+		MappedFile file(path);
+		return parse(file.begin(), file.end());
+	}
+
+	// the same for text already in memory; throws MalformedEdgeListException
+	CsrGraph parse(const char* begin, const char* end) {
+		Header header = parseHeader(begin, end);
+		std::vector<Chunk> chunks = split(header.body, end, pool().size());
+
+		pool().parallelFor(chunks.size(), 1, [&](int, size_t first, size_t last) {
+			for (size_t c = first; c < last; ++c) {
+				Chunk& chunk = chunks[c];
+				for (const char* line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end)) {
+					parseLine(line, chunk.end, header, chunk);
+				}
+			}
+		});
+
+		int nodeCount = header.nodeCount;
+		if (nodeCount < 0) {
+			// SNAP: the largest id seen
+			nodeCount = 0;
+			for (auto& chunk : chunks) {
+				nodeCount = std::max(nodeCount, chunk.maxId + 1);
+			}
+		}
+		return build(chunks, nodeCount, header.weighted, symmetrize || header.symmetric);
+	}
+
+	CsrGraph parse(const std::string& text) {
+		return parse(text.data(), text.data() + text.size());
+	}
+};
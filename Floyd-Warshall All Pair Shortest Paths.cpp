@@ -1,11 +1,30 @@
 /*
 Floyd-Warshall All Pair Shortest Paths (APSP)
 
+The distances are kept in one flat n x n matrix, padded to a multiple of the tile
+size, and the triple loop is run tile by tile so that the working set of every
+step stays in the L1/L2 cache. Missing edges are a large INF that the update
+never adds to, so sums saturate instead of overflowing. The tiles of one step
+that do not depend on each other are updated in parallel.
+
+After an edge changes, updateEdges() brings the matrices up to date in O(n^2)
+per changed edge instead of starting over.
+
+When only reachability matters, TransitiveClosure keeps one bit per pair and
+updates 64 pairs with a single OR.
 */
 #include <iostream>
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
+#include <new>
+#include <limits>
+#include <memory>
+#include <cstdint>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Depth-First Traversal.h"
+#include "Thread Pool.h"
 
 using namespace std;
 
@@ -18,66 +37,619 @@ namespace {
         NoPathExistsException() : runtime_error("No path exists between the nodes.") {}
     };
 
+    // fixed size array aligned to a cache line, so that matrix rows start
+    // on vector register boundaries
+    template <typename T>
+    class AlignedArray {
+        static constexpr size_t ALIGNMENT = 64;
+        T* values = nullptr;
+        size_t count = 0;
+
+        static T* allocate(size_t count) {
+            return count == 0 ? nullptr
+                : static_cast<T*>(::operator new[](count * sizeof(T), align_val_t(ALIGNMENT)));
+        }
+
+    public:
+        AlignedArray() = default;
+
+        AlignedArray(size_t _count, T value)
+            : values{ allocate(_count) }
+            , count{ _count } {
+            fill(values, values + count, value);
+        }
+
+        AlignedArray(const AlignedArray& other)
+            : values{ allocate(other.count) }
+            , count{ other.count } {
+            copy(other.values, other.values + count, values);
+        }
+
+        AlignedArray& operator=(AlignedArray other) {
+            swap(values, other.values);
+            swap(count, other.count);
+            return *this;
+        }
+
+        ~AlignedArray() {
+            if (values) ::operator delete[](values, align_val_t(ALIGNMENT));
+        }
+
+        T* data() { return values; }
+        const T* data() const { return values; }
+        T& operator[](size_t i) { return values[i]; }
+        const T& operator[](size_t i) const { return values[i]; }
+    };
+
+    // one changed edge for FloydWarshall::updateEdges()
+    struct EdgeUpdate {
+        int from;
+        int to;
+        // <= 0 removes the edge
+        int weight;
+    };
+
+    // blocked Floyd-Warshall on one flat, padded n x n matrix. For every diagonal tile
+    // (kb, kb) the tiles are updated in three phases:
+    //   1. the diagonal tile with itself,
+    //   2. the tiles in row kb and column kb with the diagonal tile,
+    //   3. all other tiles (i, j) with the tiles (i, kb) and (kb, j).
+    // Each update only touches three tiles that fit in the cache together, and the
+    // tiles of phase 2 and of phase 3 are independent of each other, so they are
+    // spread over the thread pool.
+    //
+    // Distance is the matrix cell type: uint16_t, int, int64_t or float. A narrower
+    // type packs more cells into a vector register and halves the matrix, but every
+    // shortest path must stay below INF = max / 2 or it reads as unreachable
+    // (32767 for uint16_t).
+    template <typename Distance = int>
     class FloydWarshall {
+    public:
+        // the distance of unreachable pairs; two of them still fit in a Distance
+        static constexpr Distance INF = numeric_limits<Distance>::max() / 2;
+
     private:
-        AdjacencyMatrix distanceMatrix;
-        AdjacencyMatrix predecessorMatrix;
         static constexpr int UNKNOWN = -1;
-        // static constexpr int INFINITY = 1'000'000'000;
+
+        // tile edge length; three int tiles take 48KB
+        static constexpr int TILE = 64;
+
+        // updateEdges() recomputes everything once more than 1 / REBUILD_FRACTION of the
+        // rows are affected, n row-wise Dijkstras are much slower than one blocked pass
+        static constexpr int REBUILD_FRACTION = 16;
+
+        int n = 0;
+        // row length of the padded matrices, a multiple of TILE
+        int stride = 0;
+        AlignedArray<Distance> distanceMatrix;
+        AlignedArray<int> predecessorMatrix;
+        // the out-edges of every node as (target, weight), sorted by target; updateEdges()
+        // recomputes rows from them. O(E) instead of a third n x n matrix
+        vector<vector<pair<int, Distance>>> outEdges;
+
+        shared_ptr<ThreadPool> threadPool;
+
+        Distance& distance(int i, int j) { return this->distanceMatrix[size_t(i) * stride + j]; }
+        int& predecessor(int i, int j) { return this->predecessorMatrix[size_t(i) * stride + j]; }
+
+        // INF for missing edges, 0 on the diagonal
+        Distance weight(int i, int j) const {
+            if (i == j) return 0;
+            const auto& edges = this->outEdges[i];
+            auto edge = lower_bound(edges.begin(), edges.end(), make_pair(j, Distance(0)));
+            return edge != edges.end() && edge->first == j ? edge->second : INF;
+        }
+
+        // INF removes the edge
+        void setWeight(int i, int j, Distance weight) {
+            auto& edges = this->outEdges[i];
+            auto edge = lower_bound(edges.begin(), edges.end(), make_pair(j, Distance(0)));
+            bool exists = edge != edges.end() && edge->first == j;
+            if (weight == INF) {
+                if (exists) edges.erase(edge);
+            }
+            else if (exists) {
+                edge->second = weight;
+            }
+            else {
+                edges.insert(edge, { j, weight });
+            }
+        }
+
+        // cRow[j] = min(cRow[j], aValue + bRow[j]) for the first length entries, taking the
+        // predecessor from bPredecessors where the distance improved. Branch-free so that it
+        // compiles to vector adds, mins and blends; since both operands are at most INF the
+        // sum cannot overflow and is clamped back to INF
+        static void relaxRow(Distance* cRow, int* cPredecessors, Distance aValue,
+            const Distance* bRow, const int* bPredecessors, int length) {
+            for (int j = 0; j < length; ++j) {
+                Distance candidate = min(Distance(aValue + bRow[j]), INF);
+                bool better = candidate < cRow[j];
+                cRow[j] = better ? candidate : cRow[j];
+                cPredecessors[j] = better ? bPredecessors[j] : cPredecessors[j];
+            }
+        }
 
         void initialize(AdjacencyMatrix const& adjacencyMatrix) {
-            int n = adjacencyMatrix.size();
-            this->distanceMatrix = AdjacencyMatrix(n, vector<int>(n, INFINITY));
-            this->predecessorMatrix = AdjacencyMatrix(n, vector<int>(n, UNKNOWN));
+            this->n = adjacencyMatrix.size();
+            this->stride = (n + TILE - 1) / TILE * TILE;
+            this->distanceMatrix = AlignedArray<Distance>(size_t(stride) * stride, INF);
+            this->predecessorMatrix = AlignedArray<int>(size_t(stride) * stride, UNKNOWN);
+            this->outEdges.assign(n, {});
             for (int i = 0; i < n; ++i) {
                 for (int j = 0; j < n; ++j) {
-                    if (i == j) {
-                        this->distanceMatrix[i][j] = 0;
-                        this->predecessorMatrix[i][j] = i;
-                    }
-                    else if (adjacencyMatrix[i][j] > 0) {
-                        this->distanceMatrix[i][j] = adjacencyMatrix[i][j];
-                        this->predecessorMatrix[i][j] = i;
+                    if (i != j && adjacencyMatrix[i][j] > 0) {
+                        this->setWeight(i, j, min(Distance(adjacencyMatrix[i][j]), INF));
                     }
                 }
             }
+            this->rebuild();
+        }
+
+        // the full computation from the edges
+        void rebuild() {
+            for (int i = 0; i < n; ++i) {
+                fill(&this->distance(i, 0), &this->distance(i, 0) + n, INF);
+                fill(&this->predecessor(i, 0), &this->predecessor(i, 0) + n, UNKNOWN);
+                this->distance(i, i) = 0;
+                this->predecessor(i, i) = i;
+                for (auto& edge : this->outEdges[i]) {
+                    this->distance(i, edge.first) = edge.second;
+                    this->predecessor(i, edge.first) = i;
+                }
+            }
+            this->compute();
+        }
+
+        // min-plus update of tile C with A (C's rows, column range k) and B (row range k,
+        // C's columns). Any of them may be the same tile, as in phases 1 and 2
+        void updateTile(int ci, int cj, int ai, int ak, int bj) {
+            Distance* distances = this->distanceMatrix.data();
+            int* predecessors = this->predecessorMatrix.data();
+
+            for (int k = 0; k < TILE; ++k) {
+                const Distance* bRow = distances + size_t(ak + k) * stride + bj;
+                const int* bPredecessors = predecessors + size_t(ak + k) * stride + bj;
+                for (int i = 0; i < TILE; ++i) {
+                    Distance aValue = distances[size_t(ai + i) * stride + ak + k];
+                    if (aValue == INF) continue;
+
+                    relaxRow(distances + size_t(ci + i) * stride + cj, predecessors + size_t(ci + i) * stride + cj,
+                        aValue, bRow, bPredecessors, TILE);
+                }
+            }
         }
 
         void compute() {
-            int n = this->distanceMatrix.size();
-            for (int k = 0; k < n; ++k) {
-                for (int i = 0; i < n; ++i) {
-                    for (int j = 0; j < n; ++j) {
-                        if (this->distanceMatrix[i][k] + this->distanceMatrix[k][j] < this->distanceMatrix[i][j]) {
-                            this->distanceMatrix[i][j] = this->distanceMatrix[i][k] + this->distanceMatrix[k][j];
-                            this->predecessorMatrix[i][j] = this->predecessorMatrix[k][j];
+            int tiles = this->stride / TILE;
+            ThreadPool& workers = *this->threadPool;
+            for (int kb = 0; kb < tiles; ++kb) {
+                int k = kb * TILE;
+
+                // phase 1: the diagonal tile
+                updateTile(k, k, k, k, k);
+
+                // phase 2: row kb and column kb, in 2 * (tiles - 1) independent tiles
+                workers.parallelFor(2 * size_t(tiles - 1), 1, [&](int, size_t begin, size_t end) {
+                    for (size_t task = begin; task < end; ++task) {
+                        int t = int(task / 2);
+                        if (t >= kb) t++;
+                        if (task % 2 == 0) {
+                            updateTile(k, t * TILE, k, k, t * TILE);
+                        }
+                        else {
+                            updateTile(t * TILE, k, t * TILE, k, k);
+                        }
+                    }
+                });
+
+                // phase 3: everything else, one row of tiles per task
+                workers.parallelFor(size_t(tiles), 1, [&](int, size_t begin, size_t end) {
+                    for (size_t ib = begin; ib < end; ++ib) {
+                        if (int(ib) == kb) continue;
+                        for (int jb = 0; jb < tiles; ++jb) {
+                            if (jb == kb) continue;
+                            updateTile(int(ib) * TILE, jb * TILE, int(ib) * TILE, k, jb * TILE);
                         }
                     }
+                });
+            }
+        }
+
+        // Dijkstra from source over the edges, replacing row source of the distance
+        // and predecessor matrices. The dense O(n^2) variant: the next node is found
+        // by a plain sweep over keys, which holds the distances of the queued nodes,
+        // INF once settled; settled nodes are never improved again since the weights
+        // are positive
+        void recomputeRow(int source, vector<Distance>& keys) {
+            Distance* distances = this->distanceMatrix.data() + size_t(source) * stride;
+            int* predecessors = this->predecessorMatrix.data() + size_t(source) * stride;
+            fill(distances, distances + n, INF);
+            fill(predecessors, predecessors + n, UNKNOWN);
+            keys.assign(n, INF);
+            distances[source] = 0;
+            predecessors[source] = source;
+            keys[source] = 0;
+
+            while (true) {
+                int u = int(min_element(keys.begin(), keys.end()) - keys.begin());
+                if (keys[u] == INF) break;
+                keys[u] = INF;
+
+                Distance distance = distances[u];
+                for (auto& edge : this->outEdges[u]) {
+                    int v = edge.first;
+                    Distance candidate = min(Distance(distance + edge.second), INF);
+                    if (candidate < distances[v]) {
+                        distances[v] = candidate;
+                        predecessors[v] = u;
+                        keys[v] = candidate;
+                    }
                 }
             }
         }
+
+        // Floyd-Warshall restricted to the pivots, given that the matrices are exact
+        // except for paths through edges that start and end at pivots. First the
+        // pivot rows and columns are closed over the pivots, O(|pivots|^2 n); they
+        // only depend on each other. Then every other row takes the best detour
+        // through one pivot in a single pass over the matrix, O(|pivots| n^2)
+        void relaxThroughPivots(const vector<int>& pivots) {
+            vector<char> isPivot(n, false);
+            for (int p : pivots) {
+                isPivot[p] = true;
+            }
+
+            Distance* distances = this->distanceMatrix.data();
+            int* predecessors = this->predecessorMatrix.data();
+            ThreadPool& workers = *this->threadPool;
+            for (int p : pivots) {
+                const Distance* pRow = distances + size_t(p) * stride;
+                const int* pPredecessors = predecessors + size_t(p) * stride;
+                workers.parallelFor(size_t(n), 64, [&](int, size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        Distance aValue = distances[i * stride + p];
+                        // row p itself cannot improve through p, and others are reading it
+                        if (aValue == INF || int(i) == p) continue;
+
+                        Distance* cRow = distances + i * stride;
+                        int* cPredecessors = predecessors + i * stride;
+                        if (isPivot[i]) {
+                            relaxRow(cRow, cPredecessors, aValue, pRow, pPredecessors, n);
+                            continue;
+                        }
+                        for (int q : pivots) {
+                            Distance candidate = min(Distance(aValue + pRow[q]), INF);
+                            if (candidate < cRow[q]) {
+                                cRow[q] = candidate;
+                                cPredecessors[q] = pPredecessors[q];
+                            }
+                        }
+                    }
+                });
+            }
+
+            workers.parallelFor(size_t(n), 16, [&](int, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    if (isPivot[i]) continue;
+
+                    Distance* cRow = distances + i * stride;
+                    int* cPredecessors = predecessors + i * stride;
+                    for (int p : pivots) {
+                        Distance aValue = cRow[p];
+                        if (aValue == INF) continue;
+                        relaxRow(cRow, cPredecessors, aValue,
+                            distances + size_t(p) * stride, predecessors + size_t(p) * stride, n);
+                    }
+                }
+            });
+        }
     public:
-        FloydWarshall(AdjacencyMatrix const& adjacencyMatrix) {
+        // threadCount 0 uses every hardware thread, 1 runs on the calling thread only
+        FloydWarshall(AdjacencyMatrix const& adjacencyMatrix, int threadCount = 1)
+            : threadPool{ make_shared<ThreadPool>(threadCount) } {
             this->initialize(adjacencyMatrix);
-            this->compute();
         }
 
-        pair<int, vector<int>> getShortestPath(int start, int end) {
-            int distance = this->distanceMatrix[start][end];
-            if (distance == INFINITY) {
+        // change the weight of edge (from, to) and bring the result up to date without
+        // the O(n^3) recomputation; a weight <= 0 removes the edge, as in the constructor
+        void updateEdge(int from, int to, int weight) {
+            updateEdges({ { from, to, weight } });
+        }
+
+        // apply a batch of edge changes, the last change of an edge wins.
+        // Lowered and inserted edges cost one pass over the matrix together,
+        // O(k n^2) for k changed edges: see relaxThroughPivots().
+        // Raised and removed edges cannot be handled that way since other distances
+        // may have been built on the old weight. Instead, row i is recomputed with
+        // one O(n^2) Dijkstra if its shortest path tree used the edge, i.e. if the
+        // predecessor of `to` on the way from i was `from`. All other rows keep
+        // their distances because raising a weight never shortens a path.
+        // If too many rows are affected, everything is recomputed instead
+        void updateEdges(vector<EdgeUpdate> updates) {
+            stable_sort(updates.begin(), updates.end(), [](const EdgeUpdate& a, const EdgeUpdate& b) {
+                return make_pair(a.from, a.to) < make_pair(b.from, b.to);
+            });
+
+            vector<char> affectedRows(n, false);
+            vector<pair<int, int>> loweredEdges;
+            for (size_t i = 0; i < updates.size(); ++i) {
+                const EdgeUpdate& update = updates[i];
+                if (update.from < 0 || update.from >= n || update.to < 0 || update.to >= n) {
+                    throw out_of_range("Edge endpoint is not a node of the graph.");
+                }
+                bool lastOfEdge = i + 1 == updates.size()
+                    || updates[i + 1].from != update.from || updates[i + 1].to != update.to;
+                if (!lastOfEdge || update.from == update.to) continue;
+
+                Distance oldWeight = this->weight(update.from, update.to);
+                Distance newWeight = update.weight > 0 ? min(Distance(update.weight), INF) : INF;
+                this->setWeight(update.from, update.to, newWeight);
+                if (newWeight < oldWeight) {
+                    loweredEdges.push_back({ update.from, update.to });
+                }
+                else if (newWeight > oldWeight) {
+                    for (int row = 0; row < n; ++row) {
+                        if (row != update.to && this->predecessor(row, update.to) == update.from) {
+                            affectedRows[row] = true;
+                        }
+                    }
+                }
+            }
+
+            // these rows already see the lowered edges
+            vector<int> rows;
+            for (int row = 0; row < n; ++row) {
+                if (affectedRows[row]) rows.push_back(row);
+            }
+            if (rows.size() > size_t(n) / REBUILD_FRACTION) {
+                // cheaper to start over with the blocked algorithm
+                this->rebuild();
+                return;
+            }
+            vector<vector<Distance>> keys(this->threadPool->size());
+            this->threadPool->parallelFor(rows.size(), 1, [&](int worker, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    recomputeRow(rows[i], keys[worker]);
+                }
+            });
+
+            vector<int> pivots;
+            for (auto& edge : loweredEdges) {
+                int from = edge.first, to = edge.second;
+                // a recomputed row `from` may already hold the new edge, the other rows
+                // still need it
+                if (this->weight(from, to) < this->distance(from, to)) {
+                    this->distance(from, to) = this->weight(from, to);
+                    this->predecessor(from, to) = from;
+                }
+                if (this->weight(from, to) == this->distance(from, to)) {
+                    pivots.push_back(from);
+                    pivots.push_back(to);
+                }
+            }
+            sort(pivots.begin(), pivots.end());
+            pivots.erase(unique(pivots.begin(), pivots.end()), pivots.end());
+            if (!pivots.empty()) {
+                relaxThroughPivots(pivots);
+            }
+        }
+
+        // INF if there is no path
+        Distance getDistance(int start, int end) const {
+            return this->distanceMatrix[size_t(start) * stride + end];
+        }
+
+        pair<Distance, vector<int>> getShortestPath(int start, int end) {
+            Distance distance = this->distanceMatrix[size_t(start) * stride + end];
+            if (distance == INF) {
                 throw NoPathExistsException();
             }
 
             vector<int> path{ end };
             int current = end;
             while (current != UNKNOWN and current != start) {
-                current = this->predecessorMatrix[start][current];
+                current = this->predecessorMatrix[size_t(start) * stride + current];
                 path.push_back(current);
             }
             std::reverse(path.begin(), path.end());
             return make_pair(distance, path);
         }
     };
+
+    // how TransitiveClosure computes reachability
+    enum class ClosureMethod {
+        // Warshall's algorithm on the n x n bit matrix: for every k, each row that
+        // reaches k takes over row k with a word-wide OR, O(n^3 / 64)
+        WARSHALL,
+        // collapse the strongly connected components first; the components form a DAG
+        // whose rows follow from their successors' rows in one pass, no k loop needed
+        CONDENSATION
+    };
+
+    // reachability only: Floyd-Warshall with "or" and "and" instead of "min" and "+",
+    // one bit per pair instead of two int matrices. Every node reaches itself
+    class TransitiveClosure {
+        static constexpr int WORD = 64;
+
+        // set only when constructed from an adjacency matrix, keeps the graph alive
+        shared_ptr<const CsrGraph> ownedGraph;
+        CsrGraphView graph;
+
+        // the rows of the bit matrix are components, every node is its own
+        // component with WARSHALL
+        vector<int> componentOf;
+        int componentCount = 0;
+        // 64 bit words per row
+        int words = 0;
+        AlignedArray<uint64_t> bits;
+
+        ThreadPool pool;
+
+        uint64_t* row(int component) { return this->bits.data() + size_t(component) * words; }
+        const uint64_t* row(int component) const { return this->bits.data() + size_t(component) * words; }
+
+        static void set(uint64_t* row, int column) { row[column / WORD] |= uint64_t(1) << (column % WORD); }
+        static bool test(const uint64_t* row, int column) { return (row[column / WORD] >> (column % WORD)) & 1; }
+
+        // row |= other, a loop the compiler turns into 256 or 512 bit ORs where available
+        void orRow(uint64_t* row, const uint64_t* other) const {
+            for (int w = 0; w < words; ++w) {
+                row[w] |= other[w];
+            }
+        }
+
+        static CsrGraph toCsrGraph(AdjacencyMatrix const& adjacencyMatrix) {
+            int n = adjacencyMatrix.size();
+            CsrGraphBuilder builder(n);
+            for (int i = 0; i < n; ++i) {
+                for (int j = 0; j < n; ++j) {
+                    if (adjacencyMatrix[i][j] > 0) {
+                        builder.addEdge(i, j);
+                    }
+                }
+            }
+            return builder.build();
+        }
+
+        void allocate(int rows) {
+            this->componentCount = rows;
+            this->words = (rows + WORD - 1) / WORD;
+            this->bits = AlignedArray<uint64_t>(size_t(rows) * words, 0);
+        }
+
+        void warshall() {
+            int n = graph.size();
+            componentOf.resize(n);
+            allocate(n);
+            for (int u = 0; u < n; ++u) {
+                componentOf[u] = u;
+                set(row(u), u);
+                for (int v : graph.neighbors(u)) {
+                    set(row(u), v);
+                }
+            }
+
+            for (int k = 0; k < n; ++k) {
+                const uint64_t* rowK = row(k);
+                pool.parallelFor(size_t(n), 64, [&](int, size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        // row k does not change in step k, and others are reading it
+                        if (int(i) != k && test(row(int(i)), k)) {
+                            orRow(row(int(i)), rowK);
+                        }
+                    }
+                });
+            }
+        }
+
+        // Pearce's SCC pass: components are numbered in the order they are completed,
+        // so every edge between two components points to a smaller number
+        void findComponents() {
+            int n = graph.size();
+            PearceSccVisitor visitor(n);
+            DepthFirstSearch search(graph);
+            search.runAll(visitor);
+
+            componentCount = visitor.componentCount();
+            componentOf.resize(n);
+            for (int u = 0; u < n; ++u) {
+                componentOf[u] = visitor.componentOf(u);
+            }
+        }
+
+        void condensation() {
+            int n = graph.size();
+            findComponents();
+            allocate(componentCount);
+
+            // members of every component in CSR form
+            vector<int> memberOffsets(componentCount + 1, 0);
+            for (int u = 0; u < n; ++u) {
+                memberOffsets[componentOf[u] + 1]++;
+            }
+            for (int c = 0; c < componentCount; ++c) {
+                memberOffsets[c + 1] += memberOffsets[c];
+            }
+            vector<int> members(n);
+            vector<int> position(memberOffsets.begin(), memberOffsets.end() - 1);
+            for (int u = 0; u < n; ++u) {
+                members[position[componentOf[u]]++] = u;
+            }
+
+            // successors of every component, and its level: the length of the longest
+            // path down to a sink. Components on one level do not reach each other
+            vector<vector<int>> successors(componentCount);
+            vector<int> level(componentCount, 0);
+            vector<int> lastSeen(componentCount, -1);
+            int levels = 0;
+            for (int c = 0; c < componentCount; ++c) {
+                for (int m = memberOffsets[c]; m < memberOffsets[c + 1]; ++m) {
+                    for (int v : graph.neighbors(members[m])) {
+                        int d = componentOf[v];
+                        if (d == c || lastSeen[d] == c) continue;
+                        lastSeen[d] = c;
+                        successors[c].push_back(d);
+                        level[c] = max(level[c], level[d] + 1);
+                    }
+                }
+                levels = max(levels, level[c] + 1);
+            }
+
+            vector<vector<int>> byLevel(levels);
+            for (int c = 0; c < componentCount; ++c) {
+                byLevel[level[c]].push_back(c);
+            }
+            for (auto& components : byLevel) {
+                pool.parallelFor(components.size(), 16, [&](int, size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        int c = components[i];
+                        set(row(c), c);
+                        for (int d : successors[c]) {
+                            orRow(row(c), row(d));
+                        }
+                    }
+                });
+            }
+        }
+
+    public:
+        // threadCount 0 uses every hardware thread, 1 runs on the calling thread only
+        TransitiveClosure(AdjacencyMatrix const& adjacencyMatrix,
+            ClosureMethod method = ClosureMethod::CONDENSATION, int threadCount = 1)
+            : ownedGraph{ make_shared<const CsrGraph>(toCsrGraph(adjacencyMatrix)) }
+            , graph{ ownedGraph->view() }
+            , pool(threadCount) {
+            method == ClosureMethod::WARSHALL ? warshall() : condensation();
+        }
+
+        // zero-copy: the caller keeps the CsrGraph alive
+        TransitiveClosure(CsrGraphView _graph,
+            ClosureMethod method = ClosureMethod::CONDENSATION, int threadCount = 1)
+            : graph{ _graph }
+            , pool(threadCount) {
+            method == ClosureMethod::WARSHALL ? warshall() : condensation();
+        }
+
+        bool isReachable(int start, int end) const {
+            return test(row(componentOf[start]), componentOf[end]);
+        }
+
+        // all nodes reachable from start, start included, in increasing order
+        vector<int> getReachable(int start) const {
+            const uint64_t* reachable = row(componentOf[start]);
+            vector<int> nodes;
+            for (int v = 0; v < graph.size(); ++v) {
+                if (test(reachable, componentOf[v])) {
+                    nodes.push_back(v);
+                }
+            }
+            return nodes;
+        }
+
+        // rows of the bit matrix, the number of nodes with WARSHALL
+        int getComponentCount() const { return componentCount; }
+    };
 }
 
 void testFloydWarshall() {
@@ -95,7 +667,7 @@ void testFloydWarshall() {
 	};
 
 	for (auto& edge : edges) {
-		adjacencyMatrix[edge[1]][edge[0]] = edge[2];
+		adjacencyMatrix[edge[0]][edge[1]] = edge[2];
 	}
 
 	FloydWarshall floydWarshall(adjacencyMatrix);
@@ -116,4 +688,23 @@ void testFloydWarshall() {
 	catch (NoPathExistsException exc) {
 		cout << "No path from 2 to 0." << endl;
 	}
+
+	// a shortcut, then removing it again
+	floydWarshall.updateEdge(0, 3, 4);
+	cout << "Length of the path after lowering 0 -> 3 to 4: " << floydWarshall.getShortestPath(0, 3).first << endl;
+	floydWarshall.updateEdges({ { 0, 3, 0 }, { 2, 3, 1 } });
+	cout << "Length of the path after removing 0 -> 3 and lowering 2 -> 3 to 1: " << floydWarshall.getShortestPath(0, 3).first << endl;
+
+	// 16 bit cells on four threads
+	FloydWarshall<uint16_t> narrowFloydWarshall(adjacencyMatrix, 4);
+	cout << "Length of the path with 16 bit distances: " << narrowFloydWarshall.getShortestPath(0, 3).first << endl;
+
+	TransitiveClosure closure(adjacencyMatrix);
+	TransitiveClosure warshallClosure(adjacencyMatrix, ClosureMethod::WARSHALL, 4);
+	cout << "Reachable from 1:";
+	for (int u : closure.getReachable(1)) {
+		cout << " " << u;
+	}
+	cout << endl << "Same with Warshall: " << (warshallClosure.getReachable(1) == closure.getReachable(1)) << endl;
+	cout << "Components: " << closure.getComponentCount() << endl;
 }
\ No newline at end of file
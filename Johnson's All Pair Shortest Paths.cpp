@@ -0,0 +1,248 @@
+/*
+Johnson's algorithm - All Pair Shortest Paths (APSP) on sparse graphs
+
+Negative edge weights are allowed as long as there is no negative cycle.
+	1. Bellman-Ford from a virtual source with a 0-weight edge to every node gives
+	   a potential h(v) <= 0 for every node.
+	2. Every edge (u, v, w) is reweighted to w + h(u) - h(v), which is never
+	   negative and keeps the same shortest paths.
+	3. Dijkstra runs from every node on the reweighted graph, in parallel, and
+	   d(u, v) = d'(u, v) - h(u) + h(v) undoes the reweighting.
+This is O(V * E log V) instead of the O(V^3) of Floyd-Warshall, and the rows
+can be streamed to a callback one source at a time so that the dense V x V
+matrix never has to exist.
+*/
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <functional>
+
+#include "Bellman-Ford Relaxation.h"
+#include "Compressed Sparse Row Graph.h"
+#include "Dijkstra Search.h"
+#include "Priority Queues.h"
+#include "Thread Pool.h"
+
+using namespace std;
+
+namespace {
+
+	typedef pair<int, int> NodeAndDistance;
+	typedef vector<vector<NodeAndDistance>> AdjacencyList;
+
+	class NoPathExistsException : public runtime_error {
+	public:
+		NoPathExistsException() : runtime_error("No path exists between the nodes.") {}
+	};
+
+	const int UNKNOWN = -1;
+	// distance of unreachable nodes; real distances can be negative, even -1
+	constexpr int INF = 1'000'000'000;
+
+	class Johnson {
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
+
+		// h(v), distances from the virtual source
+		vector<int> potentials;
+		// w + h(u) - h(v) for every edge, parallel to the CSR edge arrays,
+		// and the graph with those weights that the searches run on
+		vector<int> reducedWeights;
+		CsrGraphView reducedGraph;
+
+		// dense result of computeAllPairs(), empty until then
+		vector<int> distanceMatrix;
+		vector<int> parentMatrix;
+
+		// single row kept by getShortestPath() when there is no dense result
+		int cachedSource = UNKNOWN;
+		vector<int> cachedDistances;
+		vector<int> cachedParents;
+
+		int threadCount = 0;
+		shared_ptr<ThreadPool> threadPool;
+
+		ThreadPool& pool() {
+			if (!threadPool) {
+				threadPool = make_shared<ThreadPool>(threadCount);
+			}
+			return *threadPool;
+		}
+
+		// Bellman-Ford from the virtual source, then the reduced weights
+		void computePotentials() {
+			potentials = bellmanFordPotentials(graph);
+
+			reducedWeights.resize(graph.edgeCount());
+			for (int u = 0; u < graph.size(); ++u) {
+				for (int e = graph.edgeBegin(u); e < graph.edgeEnd(u); ++e) {
+					reducedWeights[e] = graph.weight(e) + potentials[u] - potentials[graph.target(e)];
+				}
+			}
+			reducedGraph = graph.withWeights(reducedWeights.data());
+		}
+
+		// Dijkstra from start on the reduced weights, then the real distances
+		// with INF for unreached nodes
+		void search(SearchState& scratch, int start, int* distances, int* parents) const {
+			dijkstraSearch<IndexedDaryHeap<4>>(reducedGraph, scratch, start);
+			for (int v = 0; v < graph.size(); ++v) {
+				distances[v] = scratch.distance(v) == SearchState::UNKNOWN ? INF
+					: scratch.distance(v) - potentials[start] + potentials[v];
+				parents[v] = scratch.parent(v);
+			}
+		}
+
+		static vector<int> reconstructPath(const int* parents, int start, int end) {
+			// reconstruct the path from parents
+			vector<int> path;
+			path.push_back(end);
+			int current = end;
+			while (current != start) {
+				current = parents[current];
+				path.push_back(current);
+			}
+			reverse(path.begin(), path.end());
+			return path;
+		}
+
+	public:
+		// throws NegativeCycleException
+		Johnson(const AdjacencyList& _adjacencyList)
+			: ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+			, graph{ ownedGraph->view() } {
+			computePotentials();
+		}
+
+		// zero-copy: the caller keeps the weighted CsrGraph alive,
+		// throws invalid_argument if it has no weights, NegativeCycleException
+		Johnson(CsrGraphView _graph)
+			: graph{ requireWeights(_graph) } {
+			computePotentials();
+		}
+
+		// 0 uses one thread per hardware thread
+		void setThreadCount(int _threadCount) {
+			threadCount = _threadCount;
+			threadPool.reset();
+		}
+
+		// run Dijkstra from every node and hand each row to consumer(source, distances,
+		// parents), with INF and UNKNOWN for unreachable nodes. The consumer is called from the
+		// worker threads, concurrently for different sources, and the rows are only
+		// valid during the call; memory stays O(V) per worker
+		void streamRows(const function<void(int, const vector<int>&, const vector<int>&)>& consumer) {
+			int n = graph.size();
+			ThreadPool& workers = pool();
+
+			vector<unique_ptr<SearchState>> states(workers.size());
+			vector<vector<int>> rowDistances(workers.size(), vector<int>(n));
+			vector<vector<int>> rowParents(workers.size(), vector<int>(n));
+			workers.parallelFor(n, 1, [&](int worker, size_t begin, size_t end) {
+				if (!states[worker]) {
+					states[worker] = make_unique<SearchState>(n);
+				}
+				for (size_t source = begin; source < end; ++source) {
+					search(*states[worker], int(source), rowDistances[worker].data(), rowParents[worker].data());
+					consumer(int(source), rowDistances[worker], rowParents[worker]);
+				}
+			});
+		}
+
+		// keep all rows, V x V distances and parents
+		void computeAllPairs() {
+			int n = graph.size();
+			distanceMatrix.assign(size_t(n) * n, INF);
+			parentMatrix.assign(size_t(n) * n, UNKNOWN);
+			streamRows([&](int source, const vector<int>& distances, const vector<int>& parents) {
+				copy(distances.begin(), distances.end(), distanceMatrix.begin() + size_t(source) * n);
+				copy(parents.begin(), parents.end(), parentMatrix.begin() + size_t(source) * n);
+			});
+		}
+
+		// the potentials found by Bellman-Ford, h(v) <= 0
+		const vector<int>& getPotentials() const { return potentials; }
+
+		// uses the dense result of computeAllPairs() if there is one,
+		// otherwise a single Dijkstra from start whose row is kept for the next call
+		pair<int, vector<int>> getShortestPath(int start, int end) {
+			int n = graph.size();
+			const int* distances;
+			const int* parents;
+			if (!distanceMatrix.empty()) {
+				distances = distanceMatrix.data() + size_t(start) * n;
+				parents = parentMatrix.data() + size_t(start) * n;
+			}
+			else {
+				if (cachedSource != start) {
+					SearchState scratch(n);
+					cachedDistances.resize(n);
+					cachedParents.resize(n);
+					search(scratch, start, cachedDistances.data(), cachedParents.data());
+					cachedSource = start;
+				}
+				distances = cachedDistances.data();
+				parents = cachedParents.data();
+			}
+
+			if (distances[end] == INF) {
+				throw NoPathExistsException();
+			}
+			return { distances[end], reconstructPath(parents, start, end) };
+		}
+	};
+}
+
+void testJohnson() {
+	int n = 5;
+	vector<vector<int>> edges{
+		{0, 1, 6},
+		{0, 2, 10},
+		{0, 3, 4},
+		{1, 0, 2},
+		{1, 2, -3},
+		{1, 4, 5},
+		{3, 1, 1},
+		{3, 4, 2},
+		{4, 2, -1}
+	};
+	CsrGraph graph = CsrGraphBuilder::fromWeightedEdges(n, edges);
+
+	Johnson johnson(graph);
+	johnson.setThreadCount(4);
+
+	auto result = johnson.getShortestPath(0, 2);
+	cout << "Shortest path from 0 to 2:";
+	for (int u : result.second) {
+		cout << " " << u;
+	}
+	cout << endl << "Length of the path: " << result.first << endl;
+
+	johnson.computeAllPairs();
+	cout << "Same length from the dense result: " << (johnson.getShortestPath(0, 2).first == result.first) << endl;
+
+	try {
+		johnson.getShortestPath(2, 0);
+	}
+	catch (NoPathExistsException exc) {
+		cout << "No path from 2 to 0." << endl;
+	}
+
+	// 1 -> 0 -> 1 becomes a negative cycle
+	edges.push_back({ 0, 1, -3 });
+	CsrGraph graphWithCycle = CsrGraphBuilder::fromWeightedEdges(n, edges);
+	try {
+		Johnson withCycle(graphWithCycle);
+	}
+	catch (NegativeCycleException exc) {
+		cout << "Negative cycle:";
+		for (int u : exc.getCycle()) {
+			cout << " " << u;
+		}
+		cout << endl;
+	}
+}
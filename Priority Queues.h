@@ -0,0 +1,304 @@
+/*
+Priority queues for Dijkstra-style searches
+
+All queues hold graph nodes 0..n-1 keyed by their tentative distance and share
+one small interface, so a search can be written once as a template:
+
+	update(node, key)   insert the node, or lower its key if it is queued
+	pop()               remove and return the (node, key) pair with the smallest key
+	empty()
+	clear()             drop everything that is still queued
+
+LazyBinaryHeap and RadixHeap do not support decrease-key and push a duplicate
+entry instead, so pop() can return a node that was already popped with a
+smaller key; callers skip those the same way the classic lazy Dijkstra does.
+IndexedDaryHeap and PairingHeap keep one entry per node and decrease it in place.
+
+The queues reset their per-node state while popping, so one instance can be
+reused across searches without an O(n) reinitialization.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// the std::priority_queue baseline
+class LazyBinaryHeap {
+	typedef std::pair<int, int> KeyAndNode;
+	std::priority_queue<KeyAndNode, std::vector<KeyAndNode>, std::greater<KeyAndNode>> heap;
+
+public:
+	explicit LazyBinaryHeap(int) {}
+
+	bool empty() const { return heap.empty(); }
+
+	void update(int node, int key) {
+		heap.push({ key, node });
+	}
+
+	std::pair<int, int> pop() {
+		KeyAndNode top = heap.top();
+		heap.pop();
+		return { top.second, top.first };
+	}
+
+	void clear() {
+		heap = decltype(heap)();
+	}
+};
+
+// d-ary heap with a node -> heap slot index for real decrease-key;
+// a wider node (D = 4) makes the tree shallower and the sift-down cache friendlier
+template <int D = 4>
+class IndexedDaryHeap {
+	static constexpr int ABSENT = -1;
+
+	std::vector<int> heap;
+	std::vector<int> keys;
+	std::vector<int> positions;
+
+	void place(int slot, int node) {
+		heap[slot] = node;
+		positions[node] = slot;
+	}
+
+	void siftUp(int slot) {
+		int node = heap[slot];
+		while (slot > 0) {
+			int parent = (slot - 1) / D;
+			if (keys[heap[parent]] <= keys[node]) break;
+			place(slot, heap[parent]);
+			slot = parent;
+		}
+		place(slot, node);
+	}
+
+	void siftDown(int slot) {
+		int size = static_cast<int>(heap.size());
+		int node = heap[slot];
+		while (true) {
+			int first = slot * D + 1;
+			if (first >= size) break;
+
+			int best = first;
+			int last = first + D < size ? first + D : size;
+			for (int child = first + 1; child < last; ++child) {
+				if (keys[heap[child]] < keys[heap[best]]) best = child;
+			}
+			if (keys[node] <= keys[heap[best]]) break;
+
+			place(slot, heap[best]);
+			slot = best;
+		}
+		place(slot, node);
+	}
+
+public:
+	explicit IndexedDaryHeap(int n)
+		: keys(n, INT_MAX)
+		, positions(n, ABSENT) {}
+
+	bool empty() const { return heap.empty(); }
+
+	void update(int node, int key) {
+		if (positions[node] == ABSENT) {
+			keys[node] = key;
+			heap.push_back(node);
+			siftUp(static_cast<int>(heap.size()) - 1);
+		}
+		else if (key < keys[node]) {
+			keys[node] = key;
+			siftUp(positions[node]);
+		}
+	}
+
+	std::pair<int, int> pop() {
+		int node = heap.front();
+		int last = heap.back();
+		heap.pop_back();
+		positions[node] = ABSENT;
+		if (!heap.empty()) {
+			place(0, last);
+			siftDown(0);
+		}
+		return { node, keys[node] };
+	}
+
+	void clear() {
+		for (int node : heap) {
+			positions[node] = ABSENT;
+		}
+		heap.clear();
+	}
+};
+
+// pairing heap over per-node link arrays: O(1) insert and decrease-key,
+// O(log n) amortized pop
+class PairingHeap {
+	static constexpr int NONE = -1;
+
+	std::vector<int> keys;
+	std::vector<int> child;
+	std::vector<int> sibling;
+	// parent for a first child, left sibling otherwise
+	std::vector<int> previous;
+	std::vector<bool> queued;
+	int root = NONE;
+
+	// reused by every pop
+	std::vector<int> scratch;
+
+	int link(int a, int b) {
+		if (a == NONE) return b;
+		if (b == NONE) return a;
+		if (keys[b] < keys[a]) std::swap(a, b);
+
+		// b becomes the first child of a
+		sibling[b] = child[a];
+		if (child[a] != NONE) previous[child[a]] = b;
+		previous[b] = a;
+		child[a] = b;
+		return a;
+	}
+
+	void detach(int node) {
+		if (previous[node] == NONE) return;
+		if (child[previous[node]] == node) {
+			child[previous[node]] = sibling[node];
+		}
+		else {
+			sibling[previous[node]] = sibling[node];
+		}
+		if (sibling[node] != NONE) previous[sibling[node]] = previous[node];
+		previous[node] = NONE;
+		sibling[node] = NONE;
+	}
+
+	// standard two-pass pairing of the children of a removed root
+	int mergeChildren(int first) {
+		std::vector<int>& pairs = scratch;
+		pairs.clear();
+		while (first != NONE) {
+			int a = first;
+			int b = sibling[a];
+			first = b == NONE ? NONE : sibling[b];
+			sibling[a] = previous[a] = NONE;
+			if (b != NONE) sibling[b] = previous[b] = NONE;
+			pairs.push_back(link(a, b));
+		}
+
+		int merged = NONE;
+		for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) {
+			merged = link(*it, merged);
+		}
+		return merged;
+	}
+
+public:
+	explicit PairingHeap(int n)
+		: keys(n, INT_MAX)
+		, child(n, NONE)
+		, sibling(n, NONE)
+		, previous(n, NONE)
+		, queued(n, false) {}
+
+	bool empty() const { return root == NONE; }
+
+	void update(int node, int key) {
+		if (!queued[node]) {
+			queued[node] = true;
+			keys[node] = key;
+			root = link(root, node);
+		}
+		else if (key < keys[node]) {
+			keys[node] = key;
+			if (node != root) {
+				detach(node);
+				root = link(root, node);
+			}
+		}
+	}
+
+	std::pair<int, int> pop() {
+		int node = root;
+		root = mergeChildren(child[node]);
+		child[node] = NONE;
+		queued[node] = false;
+		return { node, keys[node] };
+	}
+
+	void clear() {
+		while (!empty()) {
+			pop();
+		}
+	}
+};
+
+// radix heap for non-negative integer keys: pops must be monotone, as in Dijkstra.
+// Bucket i holds keys that first differ from the last popped key in bit i - 1,
+// so every key is moved at most 32 times in total
+class RadixHeap {
+	static constexpr int BUCKETS = 33;
+
+	std::vector<std::pair<int, int>> buckets[BUCKETS];
+	unsigned lastKey = 0;
+	size_t count = 0;
+
+	static int bucketOf(unsigned key, unsigned last) {
+		unsigned difference = key ^ last;
+		int bucket = 0;
+		while (difference) {
+			difference >>= 1;
+			bucket++;
+		}
+		return bucket;
+	}
+
+public:
+	explicit RadixHeap(int) {}
+
+	bool empty() const { return count == 0; }
+
+	void update(int node, int key) {
+		// a new search may start below the last key of the previous one
+		if (count == 0) lastKey = 0;
+		buckets[bucketOf(static_cast<unsigned>(key), lastKey)].push_back({ key, node });
+		count++;
+	}
+
+	std::pair<int, int> pop() {
+		if (buckets[0].empty()) {
+			// redistribute the first non-empty bucket around its minimum
+			int bucket = 1;
+			while (buckets[bucket].empty()) bucket++;
+
+			unsigned minimum = UINT_MAX;
+			for (auto& entry : buckets[bucket]) {
+				minimum = std::min(minimum, static_cast<unsigned>(entry.first));
+			}
+			lastKey = minimum;
+			for (auto& entry : buckets[bucket]) {
+				buckets[bucketOf(static_cast<unsigned>(entry.first), lastKey)].push_back(entry);
+			}
+			buckets[bucket].clear();
+		}
+
+		std::pair<int, int> entry = buckets[0].back();
+		buckets[0].pop_back();
+		count--;
+		return { entry.second, entry.first };
+	}
+
+	void clear() {
+		for (auto& bucket : buckets) {
+			bucket.clear();
+		}
+		lastKey = 0;
+		count = 0;
+	}
+};
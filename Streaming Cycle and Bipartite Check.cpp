@@ -0,0 +1,359 @@
+/*
+Streaming cycle and bipartite check
+
+Answers "does the graph contain a cycle yet?" and "is it still bipartite?" for an
+undirected graph that arrives one edge at a time, without ever building the
+adjacency list that CycleDetector and BipartiteCheck need.
+
+A union-find keeps the connected components seen so far and, for every node, the
+parity of its path to the root of its component, i.e. its color in a two-coloring
+of the component. An edge u - v
+	- between two components merges them, flipping the colors of one side if
+	  needed so that u and v get different colors,
+	- inside one component closes a cycle, an odd one if u and v already have
+	  the same color, which makes the graph non-bipartite for good.
+With union by rank and path compression every edge costs near O(1) amortized.
+A repeated edge counts as a cycle of length two.
+
+ConcurrentStreamingGraphCheck accepts edges from several threads at once: the
+parent pointer and the parity of a node share one atomic word, roots are linked
+with a compare-and-swap and finds shorten paths by path splitting, so no lock is
+ever taken.
+*/
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "Thread Pool.h"
+
+using namespace std;
+
+namespace {
+
+	typedef pair<int, int> Edge;
+
+	const int UNKNOWN = -1;
+
+	// what adding an edge did to the union-find
+	enum class EdgeEffect : unsigned char {
+		// the edge joined two components
+		MERGED,
+		// both endpoints were already connected by a path of even length
+		EVEN_CYCLE,
+		// both endpoints were already connected by a path of odd length,
+		// so the new cycle has odd length
+		ODD_CYCLE
+	};
+
+	class ParityUnionFind {
+		vector<int> parents;
+		vector<unsigned char> ranks;
+		// parity of the edge to the parent, 0 for roots
+		vector<unsigned char> parities;
+		int setCount;
+
+	public:
+		explicit ParityUnionFind(int n)
+			: parents(n)
+			, ranks(n, 0)
+			, parities(n, 0)
+			, setCount{ n } {
+			for (int u = 0; u < n; ++u) {
+				parents[u] = u;
+			}
+		}
+
+		int size() const { return static_cast<int>(parents.size()); }
+		int getSetCount() const { return setCount; }
+
+		// the root of u and the parity of the path from u to it
+		pair<int, int> find(int u) {
+			int root = u;
+			int parity = 0;
+			while (parents[root] != root) {
+				parity ^= parities[root];
+				root = parents[root];
+			}
+
+			// second pass: point every node of the path straight at the root
+			int remaining = parity;
+			while (parents[u] != root) {
+				int next = parents[u];
+				int nextParity = remaining ^ parities[u];
+				parents[u] = root;
+				parities[u] = static_cast<unsigned char>(remaining);
+				u = next;
+				remaining = nextParity;
+			}
+			return { root, parity };
+		}
+
+		// the edge u - v demands different colors for u and v
+		EdgeEffect unite(int u, int v) {
+			auto first = find(u);
+			auto second = find(v);
+			if (first.first == second.first) {
+				return first.second == second.second ? EdgeEffect::ODD_CYCLE : EdgeEffect::EVEN_CYCLE;
+			}
+
+			if (ranks[first.first] > ranks[second.first]) {
+				swap(first, second);
+			}
+			parents[first.first] = second.first;
+			parities[first.first] = static_cast<unsigned char>(first.second ^ second.second ^ 1);
+			if (ranks[first.first] == ranks[second.first]) {
+				ranks[second.first]++;
+			}
+			setCount--;
+			return EdgeEffect::MERGED;
+		}
+	};
+
+	// ParityUnionFind for concurrent unite() calls. Ranks cannot be updated together
+	// with the parent in one compare-and-swap, so a root is always linked under the
+	// root of higher priority, a fixed pseudo-random order of the nodes, which keeps
+	// the trees shallow in expectation and the parent pointers free of cycles
+	class ConcurrentParityUnionFind {
+		// parent << 1 | parity of the edge to the parent, roots point to themselves
+		unique_ptr<atomic<uint32_t>[]> words;
+		int nodeCount;
+		atomic<int> setCount;
+
+		static uint32_t pack(int parent, int parity) {
+			return static_cast<uint32_t>(parent) << 1 | static_cast<uint32_t>(parity);
+		}
+
+		static int parentOf(uint32_t word) { return static_cast<int>(word >> 1); }
+		static int parityOf(uint32_t word) { return static_cast<int>(word & 1); }
+
+		// multiplication by an odd constant is a bijection, so there are no ties
+		static uint32_t priority(int u) { return static_cast<uint32_t>(u) * 0x9E3779B1u; }
+
+	public:
+		explicit ConcurrentParityUnionFind(int n)
+			: words(new atomic<uint32_t>[n])
+			, nodeCount{ n }
+			, setCount{ n } {
+			for (int u = 0; u < n; ++u) {
+				words[u].store(pack(u, 0), memory_order_relaxed);
+			}
+		}
+
+		int size() const { return nodeCount; }
+		int getSetCount() const { return setCount.load(memory_order_relaxed); }
+
+		// the root of u and the parity of the path from u to it. The parity between two
+		// nodes of one component never changes, so any mix of old and new words
+		// still adds up to the right parity
+		pair<int, int> find(int u) {
+			int parity = 0;
+			uint32_t word = words[u].load(memory_order_relaxed);
+			while (parentOf(word) != u) {
+				int parent = parentOf(word);
+				uint32_t parentWord = words[parent].load(memory_order_relaxed);
+				if (parentOf(parentWord) != parent) {
+					// path splitting: u skips its parent, nothing is lost if another thread was faster
+					uint32_t expected = word;
+					words[u].compare_exchange_weak(expected,
+						pack(parentOf(parentWord), parityOf(word) ^ parityOf(parentWord)), memory_order_relaxed);
+				}
+				parity ^= parityOf(word);
+				u = parent;
+				word = parentWord;
+			}
+			return { u, parity };
+		}
+
+		// safe to call from several threads at once
+		EdgeEffect unite(int u, int v) {
+			while (true) {
+				auto first = find(u);
+				auto second = find(v);
+				if (first.first == second.first) {
+					return first.second == second.second ? EdgeEffect::ODD_CYCLE : EdgeEffect::EVEN_CYCLE;
+				}
+
+				if (priority(first.first) > priority(second.first)) {
+					swap(first, second);
+				}
+				// fails if the lower root was linked meanwhile, then look again
+				uint32_t expected = pack(first.first, 0);
+				if (words[first.first].compare_exchange_strong(expected,
+					pack(second.first, first.second ^ second.second ^ 1), memory_order_relaxed)) {
+					setCount.fetch_sub(1, memory_order_relaxed);
+					return EdgeEffect::MERGED;
+				}
+			}
+		}
+	};
+
+	class StreamingGraphCheck {
+		ParityUnionFind sets;
+		// the first edge that closed a cycle and the first one that closed an odd cycle
+		Edge cycleEdge{ UNKNOWN, UNKNOWN };
+		Edge oddCycleEdge{ UNKNOWN, UNKNOWN };
+		long long edgeCount = 0;
+
+	public:
+		explicit StreamingGraphCheck(int nodeCount)
+			: sets(nodeCount) {}
+
+		EdgeEffect addEdge(int u, int v) {
+			if (u < 0 || u >= sets.size() || v < 0 || v >= sets.size()) {
+				throw out_of_range("Edge endpoint is not a node of the graph.");
+			}
+
+			edgeCount++;
+			EdgeEffect effect = sets.unite(u, v);
+			if (effect != EdgeEffect::MERGED && cycleEdge.first == UNKNOWN) {
+				cycleEdge = { u, v };
+			}
+			if (effect == EdgeEffect::ODD_CYCLE && oddCycleEdge.first == UNKNOWN) {
+				oddCycleEdge = { u, v };
+			}
+			return effect;
+		}
+
+		long long getEdgeCount() const { return edgeCount; }
+		int getComponentCount() const { return sets.getSetCount(); }
+
+		bool hasCycle() const { return cycleEdge.first != UNKNOWN; }
+		bool isBipartite() const { return oddCycleEdge.first == UNKNOWN; }
+
+		// {UNKNOWN, UNKNOWN} as long as there is no such edge
+		Edge getCycleEdge() const { return cycleEdge; }
+		Edge getOddCycleEdge() const { return oddCycleEdge; }
+
+		bool isConnected(int u, int v) { return sets.find(u).first == sets.find(v).first; }
+
+		// 0 or 1, the two sides of a bipartition as long as isBipartite()
+		int getSide(int u) { return sets.find(u).second; }
+	};
+
+	// StreamingGraphCheck for edges coming from several threads. Which edge counts as
+	// the one closing a cycle depends on the thread timing, but whether there is a
+	// cycle or an odd cycle does not
+	class ConcurrentStreamingGraphCheck {
+		ConcurrentParityUnionFind sets;
+		// u << 32 | v of an edge that closed a cycle, NONE if there is none yet
+		atomic<uint64_t> cycleEdge{ NONE };
+		atomic<uint64_t> oddCycleEdge{ NONE };
+		atomic<long long> edgeCount{ 0 };
+
+		int threadCount = 0;
+		shared_ptr<ThreadPool> threadPool;
+
+		static constexpr uint64_t NONE = ~uint64_t(0);
+
+		static uint64_t pack(int u, int v) {
+			return static_cast<uint64_t>(u) << 32 | static_cast<uint32_t>(v);
+		}
+
+		static Edge unpack(uint64_t word) {
+			if (word == NONE) return { UNKNOWN, UNKNOWN };
+			return { static_cast<int>(word >> 32), static_cast<int>(word & 0xFFFFFFFFu) };
+		}
+
+		// only the first edge to get here is kept
+		static void record(atomic<uint64_t>& slot, int u, int v) {
+			uint64_t expected = NONE;
+			slot.compare_exchange_strong(expected, pack(u, v), memory_order_relaxed);
+		}
+
+		ThreadPool& pool() {
+			if (!threadPool) {
+				threadPool = make_shared<ThreadPool>(threadCount);
+			}
+			return *threadPool;
+		}
+
+	public:
+		explicit ConcurrentStreamingGraphCheck(int nodeCount)
+			: sets(nodeCount) {}
+
+		// 0 uses one thread per hardware thread, only used by addEdges()
+		void setThreadCount(int _threadCount) {
+			threadCount = _threadCount;
+			threadPool.reset();
+		}
+
+		// safe to call from several threads at once
+		EdgeEffect addEdge(int u, int v) {
+			if (u < 0 || u >= sets.size() || v < 0 || v >= sets.size()) {
+				throw out_of_range("Edge endpoint is not a node of the graph.");
+			}
+
+			edgeCount.fetch_add(1, memory_order_relaxed);
+			EdgeEffect effect = sets.unite(u, v);
+			if (effect != EdgeEffect::MERGED) {
+				record(cycleEdge, u, v);
+			}
+			if (effect == EdgeEffect::ODD_CYCLE) {
+				record(oddCycleEdge, u, v);
+			}
+			return effect;
+		}
+
+		// a batch of edges spread over the thread pool
+		void addEdges(const vector<Edge>& edges) {
+			pool().parallelFor(edges.size(), 4096, [&](int, size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i) {
+					addEdge(edges[i].first, edges[i].second);
+				}
+			});
+		}
+
+		long long getEdgeCount() const { return edgeCount.load(memory_order_relaxed); }
+		int getComponentCount() const { return sets.getSetCount(); }
+
+		bool hasCycle() const { return cycleEdge.load(memory_order_relaxed) != NONE; }
+		bool isBipartite() const { return oddCycleEdge.load(memory_order_relaxed) == NONE; }
+
+		// {UNKNOWN, UNKNOWN} as long as there is no such edge
+		Edge getCycleEdge() const { return unpack(cycleEdge.load(memory_order_relaxed)); }
+		Edge getOddCycleEdge() const { return unpack(oddCycleEdge.load(memory_order_relaxed)); }
+
+		bool isConnected(int u, int v) { return sets.find(u).first == sets.find(v).first; }
+
+		// 0 or 1, the two sides of a bipartition as long as isBipartite()
+		// and no edge is being added
+		int getSide(int u) { return sets.find(u).second; }
+	};
+}
+
+void testStreamingGraphCheck() {
+	int n = 6;
+	// 0 - 1 - 2 - 3 is a path, 3 - 0 closes an even cycle and 4 - 5 - 0 - 4 an odd one
+	vector<Edge> edges{ {0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 0}, {0, 4} };
+
+	StreamingGraphCheck check(n);
+	for (auto& edge : edges) {
+		check.addEdge(edge.first, edge.second);
+		cout << edge.first << " - " << edge.second << ": cycle " << check.hasCycle()
+			<< ", bipartite " << check.isBipartite() << endl;
+	}
+	cout << "First cycle closed by " << check.getCycleEdge().first << " - " << check.getCycleEdge().second << endl;
+	cout << "First odd cycle closed by " << check.getOddCycleEdge().first << " - " << check.getOddCycleEdge().second << endl;
+
+	// an even cycle of 1000000 nodes: bipartite, and the sides alternate along it
+	int m = 1000000;
+	vector<Edge> ring;
+	ring.reserve(m);
+	for (int u = 0; u < m; ++u) {
+		ring.push_back({ u, (u + 1) % m });
+	}
+	ConcurrentStreamingGraphCheck concurrent(m);
+	concurrent.setThreadCount(4);
+	concurrent.addEdges(ring);
+	cout << "Ring of " << m << " nodes: cycle " << concurrent.hasCycle()
+		<< ", bipartite " << concurrent.isBipartite()
+		<< ", sides of 0 and 1 differ " << (concurrent.getSide(0) != concurrent.getSide(1)) << endl;
+
+	concurrent.addEdge(0, 2);
+	cout << "After 0 - 2: bipartite " << concurrent.isBipartite() << endl;
+}
@@ -1,15 +1,33 @@
 /*
 Strongly Connected Components (SCC)
 
-Kosaraju's algorithm applies 2-pass DFS on the whole graph to compute SCCs.
-The first pass is ordinary forward DFS. while the second pass is backward DFS, which follows the edges in reverse direction.
+Pearce's variant of Tarjan's algorithm finds all SCCs in a single DFS pass,
+without the transposed graph that Kosaraju's algorithm needs for its second pass.
+Every node gets rindex[u], the smallest DFS index it can reach while its component
+is still open; a node whose rindex stays its own index is the root of a component,
+and the component consists of the nodes above it on the stack. Finished nodes are
+marked by reusing rindex for their component id, so Pearce's pass itself needs
+only one int and one bit per node plus the stack of open nodes.
 
+The DFS is the explicit-stack traversal of Depth-First Traversal.h, so long
+chains cannot overflow the call stack. It adds one DfsState byte per node and
+its stack of (node, next edge) pairs, at most one pair per node.
+
+ParallelStronglyConnectedComponents finds the same components on several threads
+with trimming, forward-backward reachability and coloring instead of a DFS.
 */
 
 using namespace std;
 
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Depth-First Traversal.h"
+#include "Thread Pool.h"
 
 
 namespace {
@@ -17,91 +35,337 @@ namespace {
 	// shorthand for adjustancy list
 	typedef vector<vector<int>> AdjacencyList;
 
-	enum class NodeState { UNVISITED, IN_PROGRESS, FINISHED };
+	// components in CSR form: the nodes of component c are
+	// members[offsets[c]] .. members[offsets[c + 1] - 1]. The numbering of the
+	// components depends on the class that computed the partition
+	struct ComponentPartition {
+		vector<int> componentOf;
+		vector<int> offsets;
+		vector<int> members;
+
+		int size() const { return static_cast<int>(offsets.size()) - 1; }
+
+		IntRange component(int c) const {
+			return IntRange(members.data() + offsets[c], members.data() + offsets[c + 1]);
+		}
+	};
 
 	class StronglyConnectedComponents {
-		AdjacencyList adjacencyList;
-		vector<NodeState> nodeStates;
-		vector<int> finishOrder;
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
 
 	public:
-		StronglyConnectedComponents(AdjacencyList _adjustancyList)
-			: adjacencyList(_adjustancyList)
-			, nodeStates { vector<NodeState>(_adjustancyList.size(), NodeState::UNVISITED) } {}
-
-	private:
-		// DFS with topological order
-		void dfs(int u) {
-			nodeStates[u] = NodeState::IN_PROGRESS;
-
-			for (int v : adjacencyList[u]) {
-				switch (nodeStates[v]) {
-					case  NodeState::UNVISITED: dfs(v); break;
-					// we ignore back edges and redundant edges here
-					case NodeState::IN_PROGRESS:
-					case NodeState::FINISHED: 
-						break;
-				}
-			}
+		StronglyConnectedComponents(const AdjacencyList& _adjustancyList)
+			: ownedGraph(make_shared<const CsrGraph>(_adjustancyList))
+			, graph(ownedGraph->view()) {}
+
+		// zero-copy: the caller keeps the CsrGraph alive
+		StronglyConnectedComponents(CsrGraphView _graph)
+			: graph(_graph) {}
 
-			nodeStates[u] = NodeState::FINISHED;
-			finishOrder.push_back(u);
+		// components are numbered in the order they are completed, so an edge between
+		// two components always leads from the larger to the smaller id (sinks first)
+		ComponentPartition computeScc() const {
+			int n = graph.size();
+			PearceSccVisitor visitor(n);
+			DepthFirstSearch search(graph);
+			search.runAll(visitor);
+
+			// component ids in completion order, then the members by a counting sort
+			ComponentPartition partition;
+			int count = visitor.componentCount();
+			partition.componentOf.resize(n);
+			partition.offsets.assign(count + 1, 0);
+			for (int u = 0; u < n; ++u) {
+				partition.componentOf[u] = visitor.componentOf(u);
+				partition.offsets[partition.componentOf[u] + 1]++;
+			}
+			for (int c = 0; c < count; ++c) {
+				partition.offsets[c + 1] += partition.offsets[c];
+			}
+			partition.members.resize(n);
+			vector<int> position(partition.offsets.begin(), partition.offsets.end() - 1);
+			for (int u = 0; u < n; ++u) {
+				partition.members[position[partition.componentOf[u]]++] = u;
+			}
+			return partition;
 		}
+	};
 
-		// reverse all edges i.e. {u, v} -> {v, u}
-		void transpose() {
-			// create new transposed adjacency list
-			AdjacencyList transposeList = AdjacencyList(adjacencyList.size());
+	// the same partition as StronglyConnectedComponents, computed on a thread pool in
+	// three steps (Slota et al., "BFS and Coloring-based Parallel Algorithms for
+	// Strongly Connected Components"):
+	//   1. trim: a node without live in- or out-edges is a component of its own, and
+	//      removing it can expose more such nodes,
+	//   2. forward-backward: the nodes both reachable from and reaching a pivot of
+	//      high degree form its component, usually the giant one,
+	//   3. coloring: every node takes the largest node id that reaches it; the nodes of
+	//      color r that reach r backwards form the component of r. Repeat on the rest.
+	// Component ids are renumbered by their smallest node, so the result does not
+	// depend on the thread timing, but the ids differ from computeScc() and are not
+	// in topological order
+	class ParallelStronglyConnectedComponents {
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
+		// backward reachability needs the in-edges, built on first use
+		shared_ptr<const CsrGraph> reversed;
 
-			for (int u = 0; u < adjacencyList.size(); ++u) {
-				for (int v : adjacencyList[u]) {
-					// add reverse edge (v, u)
-					transposeList[v].push_back(u);
+		int threadCount = 0;
+		shared_ptr<ThreadPool> threadPool;
+
+		static constexpr int UNASSIGNED = -1;
+		static constexpr size_t GRAIN = 256;
+
+		ThreadPool& pool() {
+			if (!threadPool) {
+				threadPool = make_shared<ThreadPool>(threadCount);
+			}
+			return *threadPool;
+		}
+
+		static bool atomicMax(atomic<int>& value, int candidate) {
+			int current = value.load(memory_order_relaxed);
+			while (candidate > current) {
+				if (value.compare_exchange_weak(current, candidate, memory_order_relaxed)) {
+					return true;
 				}
 			}
+			return false;
+		}
+
+		// level-synchronous BFS from source over the nodes that isActive accepts,
+		// claiming nodes with a compare-and-swap on visited. Returns the reached nodes
+		template <class Active>
+		vector<int> reach(ThreadPool& workers, CsrGraphView g, int source, atomic<char>* visited, Active isActive) {
+			vector<int> reached{ source };
+			vector<int> frontier{ source };
+			vector<int> next;
+			vector<vector<int>> local(workers.size());
+			visited[source].store(1, memory_order_relaxed);
 
-			// replace the adjacency list
-			adjacencyList = transposeList;
+			while (!frontier.empty()) {
+				workers.parallelFor(frontier.size(), GRAIN, [&](int worker, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						for (int v : g.neighbors(frontier[i])) {
+							// visited is only initialized for active nodes, so ask isActive first
+							char expected = 0;
+							if (isActive(v) && visited[v].load(memory_order_relaxed) == 0
+								&& visited[v].compare_exchange_strong(expected, 1, memory_order_relaxed)) {
+								local[worker].push_back(v);
+							}
+						}
+					}
+				});
+
+				next.clear();
+				for (auto& nodes : local) {
+					next.insert(next.end(), nodes.begin(), nodes.end());
+					nodes.clear();
+				}
+				reached.insert(reached.end(), next.begin(), next.end());
+				swap(frontier, next);
+			}
+			return reached;
 		}
 
 	public:
-		vector<vector<int>> computeScc() {
-			// forward DFS:
-			for (int u = 0; u < adjacencyList.size(); ++u) {
-				if (nodeStates[u] == NodeState::FINISHED)
-					continue;
+		ParallelStronglyConnectedComponents(const AdjacencyList& _adjustancyList)
+			: ownedGraph(make_shared<const CsrGraph>(_adjustancyList))
+			, graph(ownedGraph->view()) {}
+
+		// zero-copy: the caller keeps the CsrGraph alive
+		ParallelStronglyConnectedComponents(CsrGraphView _graph)
+			: graph(_graph) {}
+
+		// 0 uses one thread per hardware thread
+		void setThreadCount(int _threadCount) {
+			threadCount = _threadCount;
+			threadPool.reset();
+		}
 
-				dfs(u);
+		ComponentPartition computeScc() {
+			int n = graph.size();
+			ThreadPool& workers = pool();
+			if (!reversed) {
+				reversed = make_shared<const CsrGraph>(CsrGraph::transposeOf(graph));
 			}
+			CsrGraphView backward = reversed->view();
 
-			// store the finish order
-			vector<int> traverseOrder(finishOrder.rbegin(), finishOrder.rend());
+			unique_ptr<atomic<int>[]> componentOf(new atomic<int>[n]);
+			unique_ptr<atomic<int>[]> inDegree(new atomic<int>[n]);
+			unique_ptr<atomic<int>[]> outDegree(new atomic<int>[n]);
+			atomic<int> nextComponent{ 0 };
+			vector<vector<int>> local(workers.size());
 
-			// Backward DFS:
-			// a. transpose of graph
-			transpose();
+			auto isUnassigned = [&](int v) {
+				return componentOf[v].load(memory_order_relaxed) == UNASSIGNED;
+			};
 
-			// b. reset:
-			fill(nodeStates.begin(), nodeStates.end(), NodeState::UNVISITED);
-			finishOrder.clear();
+			// makes v its own component unless another thread got there first
+			auto claimSingleton = [&](int v) {
+				int expected = UNASSIGNED;
+				int id = nextComponent.fetch_add(1, memory_order_relaxed);
+				return componentOf[v].compare_exchange_strong(expected, id, memory_order_relaxed);
+			};
 
-			vector<vector<int>> ssc;
-			for (int u : traverseOrder) {
-				if (nodeStates[u] == NodeState::FINISHED)
-					continue;
+			// 1. trim
+			vector<int> frontier;
+			workers.parallelFor(n, GRAIN, [&](int, size_t begin, size_t end) {
+				for (size_t u = begin; u < end; ++u) {
+					componentOf[u].store(UNASSIGNED, memory_order_relaxed);
+					inDegree[u].store(backward.degree(int(u)), memory_order_relaxed);
+					outDegree[u].store(graph.degree(int(u)), memory_order_relaxed);
+				}
+			});
+			workers.parallelFor(n, GRAIN, [&](int worker, size_t begin, size_t end) {
+				for (size_t u = begin; u < end; ++u) {
+					if ((graph.degree(int(u)) == 0 || backward.degree(int(u)) == 0) && claimSingleton(int(u))) {
+						local[worker].push_back(int(u));
+					}
+				}
+			});
+			auto collect = [&](vector<int>& nodes) {
+				nodes.clear();
+				for (auto& buffer : local) {
+					nodes.insert(nodes.end(), buffer.begin(), buffer.end());
+					buffer.clear();
+				}
+			};
+			collect(frontier);
+			while (!frontier.empty()) {
+				workers.parallelFor(frontier.size(), GRAIN, [&](int worker, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						int u = frontier[i];
+						for (int v : graph.neighbors(u)) {
+							if (inDegree[v].fetch_sub(1, memory_order_relaxed) == 1 && claimSingleton(v)) {
+								local[worker].push_back(v);
+							}
+						}
+						for (int w : backward.neighbors(u)) {
+							if (outDegree[w].fetch_sub(1, memory_order_relaxed) == 1 && claimSingleton(w)) {
+								local[worker].push_back(w);
+							}
+						}
+					}
+				});
+				collect(frontier);
+			}
 
-				dfs(u);
-				ssc.push_back(finishOrder);
-				finishOrder.clear();
+			vector<int> remaining;
+			for (int u = 0; u < n; ++u) {
+				if (isUnassigned(u)) remaining.push_back(u);
 			}
 
+			// 2. forward-backward from the remaining node with the most in * out edges
+			if (!remaining.empty()) {
+				int pivot = remaining[0];
+				for (int u : remaining) {
+					if (static_cast<long long>(graph.degree(u)) * backward.degree(u)
+						> static_cast<long long>(graph.degree(pivot)) * backward.degree(pivot)) {
+						pivot = u;
+					}
+				}
+
+				unique_ptr<atomic<char>[]> forwardVisited(new atomic<char>[n]);
+				unique_ptr<atomic<char>[]> backwardVisited(new atomic<char>[n]);
+				for (int u : remaining) {
+					forwardVisited[u].store(0, memory_order_relaxed);
+					backwardVisited[u].store(0, memory_order_relaxed);
+				}
+				reach(workers, graph, pivot, forwardVisited.get(), isUnassigned);
+				vector<int> reaching = reach(workers, backward, pivot, backwardVisited.get(), isUnassigned);
+
+				int id = nextComponent.fetch_add(1, memory_order_relaxed);
+				workers.parallelFor(reaching.size(), GRAIN, [&](int, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						if (forwardVisited[reaching[i]].load(memory_order_relaxed)) {
+							componentOf[reaching[i]].store(id, memory_order_relaxed);
+						}
+					}
+				});
+				remaining.erase(remove_if(remaining.begin(), remaining.end(), [&](int u) { return !isUnassigned(u); }), remaining.end());
+			}
+
+			// 3. coloring
+			unique_ptr<atomic<int>[]> colors(new atomic<int>[n]);
+			vector<int> roots;
+			while (!remaining.empty()) {
+				for (int u : remaining) {
+					colors[u].store(u, memory_order_relaxed);
+				}
+
+				// push the largest color forward until nothing changes; updates made in
+				// the same sweep are picked up right away
+				atomic<bool> changed{ true };
+				while (changed.load()) {
+					changed.store(false);
+					workers.parallelFor(remaining.size(), GRAIN, [&](int, size_t begin, size_t end) {
+						bool localChange = false;
+						for (size_t i = begin; i < end; ++i) {
+							int u = remaining[i];
+							int color = colors[u].load(memory_order_relaxed);
+							for (int v : graph.neighbors(u)) {
+								if (isUnassigned(v) && atomicMax(colors[v], color)) {
+									localChange = true;
+								}
+							}
+						}
+						if (localChange) changed.store(true);
+					});
+				}
+
+				roots.clear();
+				for (int u : remaining) {
+					if (colors[u].load(memory_order_relaxed) == u) roots.push_back(u);
+				}
 
-			// Restore the graph
-			transpose();
-			fill(nodeStates.begin(), nodeStates.end(), NodeState::UNVISITED);
-			finishOrder.clear();
+				// the color classes are disjoint, so every root runs its own serial BFS
+				workers.parallelFor(roots.size(), 1, [&](int worker, size_t begin, size_t end) {
+					vector<int>& queue = local[worker];
+					for (size_t i = begin; i < end; ++i) {
+						int root = roots[i];
+						int id = nextComponent.fetch_add(1, memory_order_relaxed);
+						componentOf[root].store(id, memory_order_relaxed);
+						queue.assign(1, root);
+						for (size_t head = 0; head < queue.size(); ++head) {
+							for (int w : backward.neighbors(queue[head])) {
+								if (isUnassigned(w) && colors[w].load(memory_order_relaxed) == root) {
+									componentOf[w].store(id, memory_order_relaxed);
+									queue.push_back(w);
+								}
+							}
+						}
+					}
+					queue.clear();
+				});
+				remaining.erase(remove_if(remaining.begin(), remaining.end(), [&](int u) { return !isUnassigned(u); }), remaining.end());
+			}
 
-			return ssc;
+			// renumber the ids by first appearance and build the CSR form
+			ComponentPartition partition;
+			partition.componentOf.resize(n);
+			vector<int> renumbered(nextComponent.load(), UNASSIGNED);
+			int count = 0;
+			for (int u = 0; u < n; ++u) {
+				int& id = renumbered[componentOf[u].load(memory_order_relaxed)];
+				if (id == UNASSIGNED) id = count++;
+				partition.componentOf[u] = id;
+			}
+			partition.offsets.assign(count + 1, 0);
+			for (int u = 0; u < n; ++u) {
+				partition.offsets[partition.componentOf[u] + 1]++;
+			}
+			for (int c = 0; c < count; ++c) {
+				partition.offsets[c + 1] += partition.offsets[c];
+			}
+			partition.members.resize(n);
+			vector<int> position(partition.offsets.begin(), partition.offsets.end() - 1);
+			for (int u = 0; u < n; ++u) {
+				partition.members[position[partition.componentOf[u]]++] = u;
+			}
+			return partition;
 		}
 	};
 
@@ -117,13 +381,41 @@ void testSSC() {
 	}
 
 	StronglyConnectedComponents components(adjacencyList);
-	auto scc = components.computeScc();
+	ComponentPartition scc = components.computeScc();
 	cout << "Strongly connected components:" << endl;
-	for (auto component : scc) {
-		for (int u : component) {
+	for (int c = 0; c < scc.size(); ++c) {
+		for (int u : scc.component(c)) {
 			cout << u << " ";
 		}
 		cout << endl;
 	}
 	cout << endl;
+
+	// a chain this long would overflow the stack of a recursive DFS
+	int chainLength = 1'000'000;
+	CsrGraphBuilder chain(chainLength);
+	for (int u = 0; u + 1 < chainLength; ++u) {
+		chain.addEdge(u, u + 1);
+	}
+	chain.addEdge(chainLength - 1, 0);
+	CsrGraph cycle = chain.build();
+	cout << "Components of a cycle of " << chainLength << " nodes: "
+		<< StronglyConnectedComponents(cycle).computeScc().size() << endl;
+
+	ParallelStronglyConnectedComponents parallel(adjacencyList);
+	parallel.setThreadCount(4);
+	ComponentPartition parallelScc = parallel.computeScc();
+	cout << "Components found in parallel: " << parallelScc.size() << endl;
+
+	// the ids may differ, but two nodes share a component in one partition
+	// exactly when they do in the other
+	bool samePartition = parallelScc.size() == scc.size();
+	for (int u = 0; u < n; ++u) {
+		for (int v = 0; v < n; ++v) {
+			bool together = scc.componentOf[u] == scc.componentOf[v];
+			bool togetherInParallel = parallelScc.componentOf[u] == parallelScc.componentOf[v];
+			samePartition = samePartition && together == togetherInParallel;
+		}
+	}
+	cout << "Same components as the sequential pass: " << samePartition << endl;
 }
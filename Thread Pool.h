@@ -0,0 +1,137 @@
+/*
+Thread Pool
+
+A fixed set of worker threads shared by the parallel algorithm modes.
+run() executes one job on every worker, the calling thread included as
+worker 0, and returns once all of them are done, which is exactly the
+barrier a level-synchronous graph algorithm needs between two levels.
+parallelFor() hands out chunks of an index range from an atomic counter
+so that uneven node degrees still balance across the workers.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::condition_variable allDone;
+
+	const std::function<void(int)>* job = nullptr;
+	unsigned long long generation = 0;
+	int running = 0;
+	bool stopping = false;
+	std::exception_ptr failure;
+
+	void workerLoop(int worker) {
+		unsigned long long seen = 0;
+		while (true) {
+			const std::function<void(int)>* current;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+				if (stopping) return;
+				seen = generation;
+				current = job;
+			}
+
+			execute(*current, worker);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--running == 0) {
+				allDone.notify_one();
+			}
+		}
+	}
+
+	void execute(const std::function<void(int)>& task, int worker) {
+		try {
+			task(worker);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!failure) failure = std::current_exception();
+		}
+	}
+
+public:
+	// 0 picks one worker per hardware thread
+	explicit ThreadPool(int threadCount = 0) {
+		if (threadCount <= 0) {
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		// the calling thread is worker 0
+		for (int worker = 1; worker < threadCount; ++worker) {
+			threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wakeUp.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	int size() const { return static_cast<int>(threads.size()) + 1; }
+
+	// run task(worker) once on every worker and wait for all of them,
+	// the first exception thrown by a worker is rethrown here
+	void run(const std::function<void(int)>& task) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &task;
+			running = static_cast<int>(threads.size());
+			failure = nullptr;
+			generation++;
+		}
+		wakeUp.notify_all();
+
+		execute(task, 0);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		allDone.wait(lock, [&] { return running == 0; });
+		job = nullptr;
+		if (failure) {
+			std::rethrow_exception(failure);
+		}
+	}
+
+	// body(worker, begin, end) over [0, count) in chunks of at most grain indices
+	void parallelFor(size_t count, size_t grain, const std::function<void(int, size_t, size_t)>& body) {
+		if (count == 0) return;
+		grain = std::max<size_t>(grain, 1);
+
+		// not worth waking the workers for a single chunk
+		if (size() == 1 || count <= grain) {
+			body(0, 0, count);
+			return;
+		}
+
+		std::atomic<size_t> next{ 0 };
+		run([&](int worker) {
+			while (true) {
+				size_t begin = next.fetch_add(grain);
+				if (begin >= count) break;
+				body(worker, begin, std::min(count, begin + grain));
+			}
+		});
+	}
+};
@@ -9,6 +9,14 @@ using namespace std;
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <atomic>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Depth-First Traversal.h"
+#include "Thread Pool.h"
 
 
 namespace {
@@ -16,62 +24,467 @@ namespace {
 	// shorthand for adjacency list type
 	typedef vector<vector<int>> AdjacencyList;
 
-	enum class NodeState { UNVISITED, IN_PROGRESS, FINISHED };
-
 
 	class GraphIsCyclicException : public runtime_error {
+		vector<int> cycle;
+
 	public:
-		GraphIsCyclicException() : runtime_error("Topological sort cann't be performed, as graph has cycles.") {}
+		GraphIsCyclicException(vector<int> _cycle = {})
+			: runtime_error("Topological sort cann't be performed, as graph has cycles.")
+			, cycle{ move(_cycle) } {}
+
+		// the nodes of the cycle in edge order, the last one has an edge back to the first;
+		// empty if the cycle was not recorded
+		const vector<int>& getCycle() const { return cycle; }
 	};
 
 	class TopologicalSort {
-		const AdjacencyList adjacencyList;
-		vector<NodeState> nodeStates;
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
+		DepthFirstSearch search;
 
-		// used to store the DFS finishing order
-		vector<int> finishOrder;
+		// records the finishing order and stops at the first back edge,
+		// the nodes on the DFS path from its target on form the cycle
+		struct Visitor : DfsVisitor {
+			const DepthFirstSearch& search;
+			vector<int>& finishOrder;
+			vector<int>& cycle;
+
+			Visitor(const DepthFirstSearch& _search, vector<int>& _finishOrder, vector<int>& _cycle)
+				: search(_search)
+				, finishOrder(_finishOrder)
+				, cycle(_cycle) {}
+
+			bool backEdge(int, int v) {
+				cycle = search.currentPath();
+				cycle.erase(cycle.begin(), find(cycle.begin(), cycle.end(), v));
+				return false;
+			}
+
+			bool finish(int u, int) {
+				finishOrder.push_back(u);
+				return true;
+			}
+		};
 
 	public:
-		TopologicalSort(AdjacencyList _adjacencyList)
-			: adjacencyList{ _adjacencyList }
-			, nodeStates{ vector<NodeState>(adjacencyList.size(), NodeState::UNVISITED) }
+		TopologicalSort(const AdjacencyList& _adjacencyList)
+			: ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+			, graph{ ownedGraph->view() }
+			, search{ graph }
+		{}
+
+		// zero-copy: the caller keeps the CsrGraph alive
+		TopologicalSort(CsrGraphView _graph)
+			: graph{ _graph }
+			, search{ graph }
 		{}
 
-		void dfs(int u) {
-			nodeStates[u] = NodeState::IN_PROGRESS;
+		// throws GraphIsCyclicException with the first cycle found
+		vector<int> computeTopologicalSort() {
+			search.reset();
+			vector<int> finishOrder;
+			vector<int> cycle;
+			Visitor visitor(search, finishOrder, cycle);
+			if (!search.runAll(visitor)) {
+				throw GraphIsCyclicException(cycle);
+			}
+
+			// reverse finishing order
+			reverse(finishOrder.begin(), finishOrder.end());
+			return finishOrder;
+		}
+	};
+
+	// a topological order that is kept up to date while edges are added
+	// (Pearce and Kelly, "A Dynamic Topological Sort Algorithm for Directed Acyclic Graphs").
+	// An edge u -> v that already agrees with the order costs O(1). Otherwise only the
+	// nodes with positions between v and u can be affected: those reachable from v and
+	// those reaching u within that range are searched, and the second group is moved
+	// in front of the first using the positions both occupied before.
+	// The work is proportional to the affected region, not to V + E
+	class DynamicTopologicalSort {
+		vector<vector<int>> outEdges;
+		vector<vector<int>> inEdges;
+		// order[i] is the node at position i, position[u] the position of node u
+		vector<int> order;
+		vector<int> position;
 
-			for (int v : adjacencyList[u]) {
-				switch (nodeStates[v]) {
-					// discovery edge: recursively call dfs
-					case NodeState::UNVISITED:
-					dfs(v); break;
+		// a node counts as visited by the current search if its stamp matches
+		vector<unsigned> visitedStamps;
+		unsigned stamp = 0;
+		vector<int> parents;
 
-					// back edge: cycle found! There is no topological sort.
-					case NodeState::IN_PROGRESS:
-					throw GraphIsCyclicException(); break;
+		vector<int> forwardRegion;
+		vector<int> backwardRegion;
+		vector<int> stack;
 
-					// redundant edge: skip
-					case NodeState::FINISHED:
-					break;
+		bool visited(int u) const { return visitedStamps[u] == stamp; }
+
+		// nodes reachable from v with a position below upperBound; if target is reached,
+		// the path v -> .. -> target is returned and the search stops
+		vector<int> searchForward(int v, int upperBound, int target) {
+			forwardRegion.clear();
+			stack.assign(1, v);
+			visitedStamps[v] = stamp;
+			parents[v] = v;
+			while (!stack.empty()) {
+				int u = stack.back();
+				stack.pop_back();
+				forwardRegion.push_back(u);
+				for (int w : outEdges[u]) {
+					if (w == target) {
+						vector<int> path{ w, u };
+						while (u != v) {
+							u = parents[u];
+							path.push_back(u);
+						}
+						reverse(path.begin(), path.end());
+						return path;
+					}
+					if (!visited(w) && position[w] < upperBound) {
+						visitedStamps[w] = stamp;
+						parents[w] = u;
+						stack.push_back(w);
+					}
 				}
 			}
+			return {};
+		}
+
+		// nodes reaching u with a position above lowerBound
+		void searchBackward(int u, int lowerBound) {
+			backwardRegion.clear();
+			stack.assign(1, u);
+			visitedStamps[u] = stamp;
+			while (!stack.empty()) {
+				int w = stack.back();
+				stack.pop_back();
+				backwardRegion.push_back(w);
+				for (int x : inEdges[w]) {
+					if (!visited(x) && position[x] > lowerBound) {
+						visitedStamps[x] = stamp;
+						stack.push_back(x);
+					}
+				}
+			}
+		}
+
+		// the backward region goes first, each region keeps its relative order
+		void reorder() {
+			auto byPosition = [&](int a, int b) { return position[a] < position[b]; };
+			sort(forwardRegion.begin(), forwardRegion.end(), byPosition);
+			sort(backwardRegion.begin(), backwardRegion.end(), byPosition);
+
+			vector<int> nodes(backwardRegion);
+			nodes.insert(nodes.end(), forwardRegion.begin(), forwardRegion.end());
+			vector<int> slots;
+			slots.reserve(nodes.size());
+			for (int u : nodes) {
+				slots.push_back(position[u]);
+			}
+			sort(slots.begin(), slots.end());
 
-			nodeStates[u] = NodeState::FINISHED;
+			for (size_t i = 0; i < nodes.size(); ++i) {
+				position[nodes[i]] = slots[i];
+				order[slots[i]] = nodes[i];
+			}
+		}
 
-			// add to finishing order
-			finishOrder.push_back(u);
+	public:
+		// n nodes without edges, in the order 0 .. n - 1
+		explicit DynamicTopologicalSort(int n)
+			: outEdges(n)
+			, inEdges(n)
+			, order(n)
+			, position(n)
+			, visitedStamps(n, 0)
+			, parents(n) {
+			for (int u = 0; u < n; ++u) {
+				order[u] = position[u] = u;
+			}
 		}
 
+		// start from the edges of a DAG, throws GraphIsCyclicException
+		explicit DynamicTopologicalSort(CsrGraphView graph)
+			: DynamicTopologicalSort(graph.size()) {
+			order = TopologicalSort(graph).computeTopologicalSort();
+			for (int i = 0; i < graph.size(); ++i) {
+				position[order[i]] = i;
+			}
+			for (int u = 0; u < graph.size(); ++u) {
+				for (int v : graph.neighbors(u)) {
+					outEdges[u].push_back(v);
+					inEdges[v].push_back(u);
+				}
+			}
+		}
 
-		vector<int> computeTopologicalSort() {
-			for (int u = 0; u < adjacencyList.size(); ++u) {
-				if (nodeStates[u] == NodeState::FINISHED) continue;
-				dfs(u);
+		// insert u -> v and repair the order. If the edge would close a cycle it is not
+		// inserted and GraphIsCyclicException reports the cycle, from v to u
+		void addEdge(int u, int v) {
+			if (u < 0 || u >= size() || v < 0 || v >= size()) {
+				throw out_of_range("Edge endpoint is not a node of the graph.");
+			}
+			if (u == v) {
+				throw GraphIsCyclicException({ u });
 			}
 
-			// reverse finishing order
-			reverse(finishOrder.begin(), finishOrder.end());
-			return finishOrder;
+			int lowerBound = position[v];
+			int upperBound = position[u];
+			if (lowerBound < upperBound) {
+				// on wrap-around the stamps of old searches could look current again
+				if (++stamp == 0) {
+					fill(visitedStamps.begin(), visitedStamps.end(), 0);
+					stamp = 1;
+				}
+
+				vector<int> cycle = searchForward(v, upperBound, u);
+				if (!cycle.empty()) {
+					throw GraphIsCyclicException(cycle);
+				}
+				searchBackward(u, lowerBound);
+				reorder();
+			}
+
+			outEdges[u].push_back(v);
+			inEdges[v].push_back(u);
+		}
+
+		int size() const { return static_cast<int>(order.size()); }
+
+		const vector<int>& getOrder() const { return order; }
+		int getPosition(int u) const { return position[u]; }
+	};
+
+	// earliest and latest start times of the nodes of a DAG whose nodes are tasks with
+	// durations and whose edges say "must finish before", see computeCriticalPath()
+	struct CriticalPathSchedule {
+		vector<int> earliestStart;
+		vector<int> latestStart;
+		// latestStart - earliestStart, how long a node may slip without delaying the end
+		vector<int> slack;
+		// a longest chain of nodes with zero slack, from a source to a sink
+		vector<int> criticalPath;
+		// time at which the last node finishes
+		int length = 0;
+	};
+
+	// Kahn's algorithm level by level: level 0 holds the nodes without incoming edges,
+	// level i + 1 the nodes whose last predecessor is in level i. All nodes of a level
+	// can run at the same time, and the levels are built in parallel with atomic
+	// in-degree counters: whoever drops a counter to zero puts the node in the next level
+	class ParallelTopologicalSort {
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
+
+		int threadCount = 0;
+		shared_ptr<ThreadPool> threadPool;
+
+		// the nodes of level i are levelNodes[levelOffsets[i]] .. levelNodes[levelOffsets[i + 1] - 1]
+		// starts as { 0 }, zero levels until computeLevels() runs
+		vector<int> levelOffsets{ 0 };
+		vector<int> levelNodes;
+		vector<int> levelOf;
+
+		static constexpr size_t GRAIN = 256;
+
+		ThreadPool& pool() {
+			if (!threadPool) {
+				threadPool = make_shared<ThreadPool>(threadCount);
+			}
+			return *threadPool;
+		}
+
+		static void atomicMax(atomic<int>& value, int candidate) {
+			int current = value.load(memory_order_relaxed);
+			while (candidate > current && !value.compare_exchange_weak(current, candidate, memory_order_relaxed)) {}
+		}
+
+	public:
+		ParallelTopologicalSort(const AdjacencyList& _adjacencyList)
+			: ownedGraph{ make_shared<const CsrGraph>(_adjacencyList) }
+			, graph{ ownedGraph->view() }
+		{}
+
+		// zero-copy: the caller keeps the CsrGraph alive
+		ParallelTopologicalSort(CsrGraphView _graph)
+			: graph{ _graph }
+		{}
+
+		// 0 uses one thread per hardware thread
+		void setThreadCount(int _threadCount) {
+			threadCount = _threadCount;
+			threadPool.reset();
+		}
+
+		// throws GraphIsCyclicException if some nodes never become free
+		void computeLevels() {
+			int n = graph.size();
+			ThreadPool& workers = pool();
+
+			unique_ptr<atomic<int>[]> inDegree(new atomic<int>[n]);
+			workers.parallelFor(n, GRAIN, [&](int, size_t begin, size_t end) {
+				for (size_t u = begin; u < end; ++u) {
+					inDegree[u].store(0, memory_order_relaxed);
+				}
+			});
+			workers.parallelFor(n, GRAIN, [&](int, size_t begin, size_t end) {
+				for (size_t u = begin; u < end; ++u) {
+					for (int v : graph.neighbors(int(u))) {
+						inDegree[v].fetch_add(1, memory_order_relaxed);
+					}
+				}
+			});
+
+			vector<vector<int>> local(workers.size());
+			auto appendLevel = [&]() {
+				size_t begin = levelNodes.size();
+				for (auto& nodes : local) {
+					levelNodes.insert(levelNodes.end(), nodes.begin(), nodes.end());
+					nodes.clear();
+				}
+				// the threads finish in any order, sorting keeps the result deterministic
+				sort(levelNodes.begin() + begin, levelNodes.end());
+				for (size_t i = begin; i < levelNodes.size(); ++i) {
+					levelOf[levelNodes[i]] = int(levelOffsets.size()) - 1;
+				}
+				levelOffsets.push_back(int(levelNodes.size()));
+			};
+
+			levelNodes.clear();
+			levelNodes.reserve(n);
+			levelOffsets.assign(1, 0);
+			levelOf.assign(n, -1);
+			workers.parallelFor(n, GRAIN, [&](int worker, size_t begin, size_t end) {
+				for (size_t u = begin; u < end; ++u) {
+					if (inDegree[u].load(memory_order_relaxed) == 0) {
+						local[worker].push_back(int(u));
+					}
+				}
+			});
+			appendLevel();
+
+			while (levelOffsets[levelOffsets.size() - 2] < levelOffsets.back()) {
+				int first = levelOffsets[levelOffsets.size() - 2];
+				int last = levelOffsets.back();
+				workers.parallelFor(size_t(last - first), GRAIN, [&](int worker, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						for (int v : graph.neighbors(levelNodes[first + i])) {
+							if (inDegree[v].fetch_sub(1, memory_order_relaxed) == 1) {
+								local[worker].push_back(v);
+							}
+						}
+					}
+				});
+				appendLevel();
+			}
+			// the last level is always empty
+			levelOffsets.pop_back();
+
+			if (int(levelNodes.size()) < n) {
+				throw GraphIsCyclicException();
+			}
+		}
+
+		// results of computeLevels()
+		int getLevelCount() const { return static_cast<int>(levelOffsets.size()) - 1; }
+
+		IntRange getLevel(int level) const {
+			return IntRange(levelNodes.data() + levelOffsets[level], levelNodes.data() + levelOffsets[level + 1]);
+		}
+
+		const vector<int>& getLevelOf() const { return levelOf; }
+
+		// the levels one after the other, a valid topological order
+		const vector<int>& getOrder() const { return levelNodes; }
+
+		// longest path scheduling for nodes that take durations[u] each: forward over the
+		// levels for the earliest starts, backward for the latest starts that still
+		// finish everything by the earliest possible end. Calls computeLevels() first
+		CriticalPathSchedule computeCriticalPath(const vector<int>& durations) {
+			int n = graph.size();
+			if (int(durations.size()) != n) {
+				throw invalid_argument("There must be one duration per node.");
+			}
+			computeLevels();
+			// an empty graph has no level 0 to start the critical path from
+			if (getLevelCount() == 0) {
+				return CriticalPathSchedule();
+			}
+			ThreadPool& workers = pool();
+
+			// a node's predecessors are all in earlier levels, so pushing the finish times
+			// forward one level at a time leaves every start final before it is read
+			unique_ptr<atomic<int>[]> earliestStart(new atomic<int>[n]);
+			for (int u = 0; u < n; ++u) {
+				earliestStart[u].store(0, memory_order_relaxed);
+			}
+			for (int level = 0; level < getLevelCount(); ++level) {
+				IntRange nodes = getLevel(level);
+				workers.parallelFor(nodes.size(), GRAIN, [&](int, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						int u = nodes[int(i)];
+						int finish = earliestStart[u].load(memory_order_relaxed) + durations[u];
+						for (int v : graph.neighbors(u)) {
+							atomicMax(earliestStart[v], finish);
+						}
+					}
+				});
+			}
+
+			CriticalPathSchedule schedule;
+			schedule.earliestStart.resize(n);
+			for (int u = 0; u < n; ++u) {
+				schedule.earliestStart[u] = earliestStart[u].load(memory_order_relaxed);
+				schedule.length = max(schedule.length, schedule.earliestStart[u] + durations[u]);
+			}
+
+			// successors are all in later levels, so each node only reads final values
+			schedule.latestStart.resize(n);
+			for (int level = getLevelCount() - 1; level >= 0; --level) {
+				IntRange nodes = getLevel(level);
+				workers.parallelFor(nodes.size(), GRAIN, [&](int, size_t begin, size_t end) {
+					for (size_t i = begin; i < end; ++i) {
+						int u = nodes[int(i)];
+						int latestFinish = schedule.length;
+						for (int v : graph.neighbors(u)) {
+							latestFinish = min(latestFinish, schedule.latestStart[v]);
+						}
+						schedule.latestStart[u] = latestFinish - durations[u];
+					}
+				});
+			}
+
+			schedule.slack.resize(n);
+			for (int u = 0; u < n; ++u) {
+				schedule.slack[u] = schedule.latestStart[u] - schedule.earliestStart[u];
+			}
+
+			// from a critical source, keep following a critical successor that starts
+			// right when the current node finishes
+			int current = -1;
+			for (int u : getLevel(0)) {
+				if (schedule.slack[u] == 0) {
+					current = u;
+					break;
+				}
+			}
+			while (current != -1) {
+				schedule.criticalPath.push_back(current);
+				int finish = schedule.earliestStart[current] + durations[current];
+				int next = -1;
+				for (int v : graph.neighbors(current)) {
+					if (schedule.slack[v] == 0 && schedule.earliestStart[v] == finish) {
+						next = v;
+						break;
+					}
+				}
+				current = next;
+			}
+			return schedule;
 		}
 	};
 }
@@ -91,4 +504,40 @@ void testTopologicalSort() {
 		cout << " " << u;
 	}
 	cout << endl;
+
+	CsrGraph graph(adjacencyList);
+	DynamicTopologicalSort dynamicSort(graph);
+	// 0 -> 2 moves 0 in front of 2
+	dynamicSort.addEdge(0, 2);
+	cout << "Order after adding 0 -> 2:";
+	for (int u : dynamicSort.getOrder()) {
+		cout << " " << u;
+	}
+	cout << endl;
+	try {
+		dynamicSort.addEdge(1, 3);
+	}
+	catch (GraphIsCyclicException exc) {
+		cout << "Adding 1 -> 3 closes the cycle:";
+		for (int u : exc.getCycle()) {
+			cout << " " << u;
+		}
+		cout << endl;
+	}
+
+	ParallelTopologicalSort levels(graph);
+	levels.setThreadCount(4);
+	CriticalPathSchedule schedule = levels.computeCriticalPath({ 2, 1, 4, 3, 2 });
+	for (int level = 0; level < levels.getLevelCount(); ++level) {
+		cout << "Level " << level << ":";
+		for (int u : levels.getLevel(level)) {
+			cout << " " << u << " (slack " << schedule.slack[u] << ")";
+		}
+		cout << endl;
+	}
+	cout << "Critical path:";
+	for (int u : schedule.criticalPath) {
+		cout << " " << u;
+	}
+	cout << endl << "Length of the schedule: " << schedule.length << endl;
 }
\ No newline at end of file
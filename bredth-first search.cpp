@@ -7,6 +7,17 @@ Bredth-first search
 #include <vector>
 #include <algorithm>
 #include <stdexcept>
+#include <memory>
+#include <cstdint>
+#include <atomic>
+#include <array>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Compressed Sparse Row Graph.h"
+#include "Thread Pool.h"
 
 using namespace std;
 
@@ -22,27 +33,77 @@ namespace {
 		NoPathExistsException() : runtime_error("No path exists between the nodes.") {}
 	};
 
+	enum class BfsMode {
+		// classic queue based traversal
+		TOP_DOWN,
+		// switches to bottom-up steps while the frontier is large (Beamer et al.)
+		DIRECTION_OPTIMIZING,
+		// level-synchronous top-down traversal spread over a thread pool
+		PARALLEL
+	};
+
+	// point-to-point searches used by computeShortestPath
+	enum class PathSearch {
+		// full bfs from the start node, fills distances and parents
+		FULL,
+		// forward bfs that stops as soon as the end node is discovered
+		EARLY_EXIT,
+		// expands the smaller of a forward and a backward frontier until they meet
+		BIDIRECTIONAL
+	};
+
 	class ShortestPaths {
 	private:
-		const AdjacencyList adjacencyList;
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
 		vector<int> distances;
 		vector<int> parents;
 
+		// incoming edges for the bottom-up steps, built on first use
+		shared_ptr<const CsrGraph> reverseGraph;
+
+		// go bottom-up once the frontier has more than 1/ALPHA of the unexplored edges,
+		// go back top-down once it holds less than 1/BETA of the nodes
+		static constexpr long long ALPHA = 14;
+		static constexpr long long BETA = 24;
+
+		// parallel mode: workers and the parents they claim with compare-and-swap,
+		// both created on first use and kept for the next queries
+		int threadCount = 0;
+		shared_ptr<ThreadPool> threadPool;
+		shared_ptr<atomic<int>[]> claimedParents;
+		static constexpr size_t GRAIN = 64;
+
+		// point-to-point scratch for the forward (0) and backward (1) search,
+		// kept all UNKNOWN between queries by resetting only the touched nodes
+		vector<int> searchDistances[2];
+		vector<int> searchParents[2];
+		vector<int> touchedNodes;
+
 	public:
-		ShortestPaths(AdjacencyList _adjacencyList)
-			: adjacencyList (_adjacencyList)
+		ShortestPaths(const AdjacencyList& _adjacencyList)
+			: ownedGraph(make_shared<const CsrGraph>(_adjacencyList))
+			, graph(ownedGraph->view())
 			, distances(vector<int>(_adjacencyList.size(), UNKNOWN))
 			, parents(vector<int>(_adjacencyList.size(), UNKNOWN)) {}
 
-		void bfs(int start) {
-			// initialization
-			distances.assign(distances.size(), UNKNOWN);
-			parents.assign(parents.size(), UNKNOWN);
+		// zero-copy: the caller keeps the CsrGraph alive
+		ShortestPaths(CsrGraphView _graph)
+			: graph(_graph)
+			, distances(vector<int>(_graph.size(), UNKNOWN))
+			, parents(vector<int>(_graph.size(), UNKNOWN)) {}
+
+	private:
+		const CsrGraph& transposed() {
+			if (!reverseGraph) {
+				reverseGraph = make_shared<const CsrGraph>(CsrGraph::transposeOf(graph));
+			}
+			return *reverseGraph;
+		}
 
+		void topDownBfs(int start) {
 			queue<int> unexplored;
-			
-			distances[start] = 0;
-			parents[start] = start;
 			unexplored.push(start);
 
 			// bfs main loop
@@ -50,7 +111,7 @@ namespace {
 				int u = unexplored.front();
 				unexplored.pop();
 
-				for (int v : adjacencyList[u]) {
+				for (int v : graph.neighbors(u)) {
 					if (parents[v] == UNKNOWN) {
 						// assign parent and distance
 						parents[v] = u;
@@ -63,8 +124,399 @@ namespace {
 			}
 		}
 
-		vector<int> computeShortestPath(int start, int end) {
-			bfs(start);
+		static bool testBit(const vector<uint64_t>& bits, int u) {
+			return (bits[u >> 6] >> (u & 63)) & 1;
+		}
+
+		static void setBit(vector<uint64_t>& bits, int u) {
+			bits[u >> 6] |= uint64_t(1) << (u & 63);
+		}
+
+		// index of the lowest set bit, word must not be 0
+		static int lowestBit(uint64_t word) {
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, word);
+			return static_cast<int>(index);
+#else
+			return __builtin_ctzll(word);
+#endif
+		}
+
+		void directionOptimizingBfs(int start) {
+			int n = graph.size();
+			CsrGraphView reverse = transposed().view();
+
+			// the frontier is a node list while going top-down and a bitmap while going bottom-up
+			vector<int> frontier{ start };
+			vector<int> next;
+			vector<uint64_t> frontierBits((n + 63) / 64, 0);
+			vector<uint64_t> nextBits((n + 63) / 64, 0);
+			bool bottomUp = false;
+
+			long long frontierSize = 1;
+			long long frontierEdges = graph.degree(start);
+			long long unexploredEdges = graph.edgeCount() - frontierEdges;
+
+			for (int level = 0; frontierSize > 0; ++level) {
+				if (!bottomUp && frontierEdges > unexploredEdges / ALPHA) {
+					// list -> bitmap
+					fill(frontierBits.begin(), frontierBits.end(), 0);
+					for (int u : frontier) {
+						setBit(frontierBits, u);
+					}
+					bottomUp = true;
+				}
+				else if (bottomUp && frontierSize < n / BETA) {
+					// bitmap -> list
+					frontier.clear();
+					for (int u = 0; u < n; ++u) {
+						if (testBit(frontierBits, u)) {
+							frontier.push_back(u);
+						}
+					}
+					bottomUp = false;
+				}
+
+				frontierSize = 0;
+				frontierEdges = 0;
+
+				if (bottomUp) {
+					// every undiscovered node looks for any parent in the frontier,
+					// and stops scanning its in-edges as soon as it finds one
+					fill(nextBits.begin(), nextBits.end(), 0);
+					for (int v = 0; v < n; ++v) {
+						if (parents[v] != UNKNOWN) continue;
+
+						for (int u : reverse.neighbors(v)) {
+							if (testBit(frontierBits, u)) {
+								parents[v] = u;
+								distances[v] = level + 1;
+								setBit(nextBits, v);
+								frontierSize++;
+								frontierEdges += graph.degree(v);
+								break;
+							}
+						}
+					}
+					swap(frontierBits, nextBits);
+				}
+				else {
+					next.clear();
+					for (int u : frontier) {
+						for (int v : graph.neighbors(u)) {
+							if (parents[v] == UNKNOWN) {
+								parents[v] = u;
+								distances[v] = level + 1;
+								next.push_back(v);
+								frontierEdges += graph.degree(v);
+							}
+						}
+					}
+					frontierSize = next.size();
+					swap(frontier, next);
+				}
+
+				unexploredEdges -= frontierEdges;
+			}
+		}
+
+		ThreadPool& pool() {
+			if (!threadPool) {
+				threadPool = make_shared<ThreadPool>(threadCount);
+			}
+			return *threadPool;
+		}
+
+		void parallelBfs(int start) {
+			int n = graph.size();
+			ThreadPool& workers = pool();
+			if (!claimedParents) {
+				claimedParents = shared_ptr<atomic<int>[]>(new atomic<int>[n]);
+			}
+			atomic<int>* claimed = claimedParents.get();
+
+			workers.parallelFor(n, 4096, [&](int, size_t begin, size_t end) {
+				for (size_t v = begin; v < end; ++v) {
+					claimed[v].store(UNKNOWN, memory_order_relaxed);
+				}
+			});
+			claimed[start].store(start, memory_order_relaxed);
+
+			vector<int> frontier{ start };
+			vector<vector<int>> localNext(workers.size());
+			vector<size_t> localOffsets(workers.size() + 1);
+
+			for (int level = 0; !frontier.empty(); ++level) {
+				// expand the frontier, each worker collects the nodes it claimed
+				workers.parallelFor(frontier.size(), GRAIN, [&](int worker, size_t begin, size_t end) {
+					vector<int>& next = localNext[worker];
+					for (size_t i = begin; i < end; ++i) {
+						int u = frontier[i];
+						for (int v : graph.neighbors(u)) {
+							// cheap check first, only race for nodes that still look free
+							int expected = UNKNOWN;
+							if (claimed[v].load(memory_order_relaxed) == UNKNOWN
+								&& claimed[v].compare_exchange_strong(expected, u, memory_order_relaxed)) {
+								distances[v] = level + 1;
+								next.push_back(v);
+							}
+						}
+					}
+				});
+
+				// concatenate the local buffers into the next frontier
+				for (size_t worker = 0; worker < localNext.size(); ++worker) {
+					localOffsets[worker + 1] = localOffsets[worker] + localNext[worker].size();
+				}
+				frontier.resize(localOffsets.back());
+				workers.run([&](int worker) {
+					copy(localNext[worker].begin(), localNext[worker].end(), frontier.begin() + localOffsets[worker]);
+					localNext[worker].clear();
+				});
+			}
+
+			workers.parallelFor(n, 4096, [&](int, size_t begin, size_t end) {
+				for (size_t v = begin; v < end; ++v) {
+					parents[v] = claimed[v].load(memory_order_relaxed);
+				}
+			});
+		}
+
+		// one bit per source of the batch, WORDS * 64 sources at once;
+		// the word loops are simple enough for the compiler to vectorize
+		template <int WORDS>
+		struct SourceMask {
+			array<uint64_t, WORDS> words{};
+
+			bool any() const {
+				uint64_t combined = 0;
+				for (int i = 0; i < WORDS; ++i) combined |= words[i];
+				return combined != 0;
+			}
+		};
+
+		// MS-BFS (Then et al.): every node keeps the set of sources that have seen it and
+		// the set that reached it on the current level, so one scan of an adjacency
+		// list advances all sources of the batch that are currently at that node
+		template <int WORDS>
+		void multiSourceBatch(const vector<int>& sources, size_t first, size_t count, vector<vector<int>>& table) {
+			typedef SourceMask<WORDS> Mask;
+			int n = graph.size();
+			vector<Mask> seen(n), frontier(n), next(n);
+
+			for (size_t i = 0; i < count; ++i) {
+				int s = sources[first + i];
+				seen[s].words[i >> 6] |= uint64_t(1) << (i & 63);
+				frontier[s].words[i >> 6] |= uint64_t(1) << (i & 63);
+				table[first + i][s] = 0;
+			}
+
+			for (int level = 1; ; ++level) {
+				// push the frontier bits of every active node to its neighbors
+				for (int u = 0; u < n; ++u) {
+					if (!frontier[u].any()) continue;
+					for (int v : graph.neighbors(u)) {
+						for (int i = 0; i < WORDS; ++i) {
+							next[v].words[i] |= frontier[u].words[i];
+						}
+					}
+				}
+
+				// keep only the sources that reach a node for the first time
+				bool active = false;
+				for (int v = 0; v < n; ++v) {
+					for (int i = 0; i < WORDS; ++i) {
+						uint64_t discovered = next[v].words[i] & ~seen[v].words[i];
+						seen[v].words[i] |= discovered;
+						frontier[v].words[i] = discovered;
+						next[v].words[i] = 0;
+
+						active |= discovered != 0;
+						// one step per source that found v, not per bit
+						while (discovered) {
+							table[first + i * 64 + lowestBit(discovered)][v] = level;
+							discovered &= discovered - 1;
+						}
+					}
+				}
+
+				if (!active) break;
+			}
+		}
+
+		void prepareSearch() {
+			if (searchDistances[0].empty()) {
+				for (int side = 0; side < 2; ++side) {
+					searchDistances[side].assign(graph.size(), UNKNOWN);
+					searchParents[side].assign(graph.size(), UNKNOWN);
+				}
+			}
+		}
+
+		void discover(int side, int v, int parent, int distance) {
+			if (searchDistances[0][v] == UNKNOWN && searchDistances[1][v] == UNKNOWN) {
+				touchedNodes.push_back(v);
+			}
+			searchDistances[side][v] = distance;
+			searchParents[side][v] = parent;
+		}
+
+		void finishSearch() {
+			for (int v : touchedNodes) {
+				for (int side = 0; side < 2; ++side) {
+					searchDistances[side][v] = UNKNOWN;
+					searchParents[side][v] = UNKNOWN;
+				}
+			}
+			touchedNodes.clear();
+		}
+
+		// follow the parents of one search side from node until its root
+		void appendParentChain(int side, int node, vector<int>& path) {
+			path.push_back(node);
+			while (searchParents[side][node] != node) {
+				node = searchParents[side][node];
+				path.push_back(node);
+			}
+		}
+
+		vector<int> earlyExitPath(int start, int end) {
+			prepareSearch();
+
+			queue<int> unexplored;
+			discover(0, start, start, 0);
+			unexplored.push(start);
+
+			while (!unexplored.empty() && searchDistances[0][end] == UNKNOWN) {
+				int u = unexplored.front();
+				unexplored.pop();
+
+				for (int v : graph.neighbors(u)) {
+					if (searchDistances[0][v] == UNKNOWN) {
+						discover(0, v, u, searchDistances[0][u] + 1);
+						if (v == end) break;
+						unexplored.push(v);
+					}
+				}
+			}
+
+			vector<int> path;
+			if (searchDistances[0][end] != UNKNOWN) {
+				appendParentChain(0, end, path);
+				std::reverse(path.begin(), path.end());
+			}
+			finishSearch();
+
+			if (path.empty()) {
+				throw NoPathExistsException();
+			}
+			return path;
+		}
+
+		vector<int> bidirectionalPath(int start, int end) {
+			prepareSearch();
+
+			CsrGraphView directions[2] = { graph, transposed().view() };
+			vector<int> frontiers[2] = { { start }, { end } };
+			vector<int> next;
+			discover(0, start, start, 0);
+			discover(1, end, end, 0);
+
+			// best meeting edge (meetFrom -> meetTo) found so far, meetFrom is reached
+			// by the forward search and meetTo by the backward search
+			int best = start == end ? 0 : -1;
+			int meetFrom = start, meetTo = end;
+
+			while (best == -1 && !frontiers[0].empty() && !frontiers[1].empty()) {
+				// always grow the cheaper side
+				int side = frontiers[0].size() <= frontiers[1].size() ? 0 : 1;
+				int other = 1 - side;
+
+				// the whole level is expanded, so the shortest meeting of this level wins
+				next.clear();
+				for (int u : frontiers[side]) {
+					for (int v : directions[side].neighbors(u)) {
+						if (searchDistances[other][v] != UNKNOWN) {
+							int length = searchDistances[side][u] + 1 + searchDistances[other][v];
+							if (best == -1 || length < best) {
+								best = length;
+								meetFrom = side == 0 ? u : v;
+								meetTo = side == 0 ? v : u;
+							}
+						}
+						if (searchDistances[side][v] == UNKNOWN) {
+							discover(side, v, u, searchDistances[side][u] + 1);
+							next.push_back(v);
+						}
+					}
+				}
+				swap(frontiers[side], next);
+			}
+
+			vector<int> path;
+			if (best != -1) {
+				appendParentChain(0, meetFrom, path);
+				std::reverse(path.begin(), path.end());
+				if (meetTo != meetFrom) {
+					appendParentChain(1, meetTo, path);
+				}
+			}
+			finishSearch();
+
+			if (path.empty()) {
+				throw NoPathExistsException();
+			}
+			return path;
+		}
+
+	public:
+		// distances from every source at once, row i holds the distances from sources[i];
+		// sources are processed in batches of up to 256 with a single adjacency scan per level
+		vector<vector<int>> multiSourceBfs(const vector<int>& sources) {
+			int n = graph.size();
+			vector<vector<int>> table(sources.size(), vector<int>(n, UNKNOWN));
+
+			for (size_t first = 0; first < sources.size(); first += 256) {
+				size_t count = min<size_t>(256, sources.size() - first);
+				if (count <= 64) {
+					multiSourceBatch<1>(sources, first, count, table);
+				}
+				else {
+					multiSourceBatch<4>(sources, first, count, table);
+				}
+			}
+			return table;
+		}
+
+		// 0 uses one thread per hardware thread, takes effect for the next parallel bfs
+		void setThreadCount(int _threadCount) {
+			threadCount = _threadCount;
+			threadPool.reset();
+		}
+
+		// distances are the same in every mode, parents may differ between
+		// equally short BFS trees
+		void bfs(int start, BfsMode mode = BfsMode::TOP_DOWN) {
+			// initialization
+			distances.assign(distances.size(), UNKNOWN);
+			parents.assign(parents.size(), UNKNOWN);
+
+			distances[start] = 0;
+			parents[start] = start;
+
+			switch (mode) {
+				case BfsMode::TOP_DOWN: topDownBfs(start); break;
+				case BfsMode::DIRECTION_OPTIMIZING: directionOptimizingBfs(start); break;
+				case BfsMode::PARALLEL: parallelBfs(start); break;
+			}
+		}
+
+		const vector<int>& getDistances() const { return distances; }
+		const vector<int>& getParents() const { return parents; }
+
+		vector<int> computeShortestPath(int start, int end, BfsMode mode = BfsMode::TOP_DOWN) {
+			bfs(start, mode);
 			// end was not discovered -> no path
 			if (distances[end] == UNKNOWN) {
 				throw NoPathExistsException();
@@ -85,6 +537,17 @@ namespace {
 			return path;
 		}
 
+		// EARLY_EXIT and BIDIRECTIONAL only touch the neighborhood they explore
+		// and leave distances and parents alone
+		vector<int> computeShortestPath(int start, int end, PathSearch search) {
+			switch (search) {
+				case PathSearch::EARLY_EXIT: return earlyExitPath(start, end);
+				case PathSearch::BIDIRECTIONAL: return bidirectionalPath(start, end);
+				case PathSearch::FULL: break;
+			}
+			return computeShortestPath(start, end);
+		}
+
 	};
 
 	void testShortestPath() {
@@ -121,9 +584,96 @@ namespace {
 			cout << "No path from 5 to 0." << endl;
 		}		
 	}
+
+	void testSharedGraph() {
+		// build the graph once, every algorithm only keeps a view of it
+		CsrGraph graph = CsrGraphBuilder::fromEdges(6, { {0, 1}, {0, 2}, {1, 3}, {2, 4}, {3, 0}, {3, 4}, {4, 3}, {4, 5} });
+
+		ShortestPaths shortestPaths(graph);
+		vector<int> path05 = shortestPaths.computeShortestPath(0, 5);
+		cout << "Shortest path from 0 to 5 on a shared graph: ";
+		for (int u : path05) {
+			cout << u << " ";
+		}
+		cout << endl;
+	}
+
+	void testDirectionOptimizing() {
+		// a small low-diameter graph, big enough for the bottom-up steps to kick in
+		int n = 1000;
+		CsrGraphBuilder builder(n);
+		for (int u = 0; u < n; ++u) {
+			builder.addEdge(u, (u * 7 + 1) % n);
+			builder.addEdge(u, (u * 13 + 5) % n);
+			builder.addEdge(u, u / 2);
+		}
+		CsrGraph graph = builder.build();
+
+		ShortestPaths topDown(graph);
+		ShortestPaths directionOptimizing(graph);
+		topDown.bfs(0, BfsMode::TOP_DOWN);
+		directionOptimizing.bfs(0, BfsMode::DIRECTION_OPTIMIZING);
+		cout << "Direction-optimizing BFS matches top-down distances: "
+			<< (topDown.getDistances() == directionOptimizing.getDistances()) << endl;
+
+		ShortestPaths parallel(graph);
+		parallel.setThreadCount(4);
+		parallel.bfs(0, BfsMode::PARALLEL);
+		cout << "Parallel BFS matches top-down distances: "
+			<< (topDown.getDistances() == parallel.getDistances()) << endl;
+	}
+
+	void testMultiSourceBfs() {
+		int n = 1000;
+		CsrGraphBuilder builder(n);
+		for (int u = 0; u < n; ++u) {
+			builder.addEdge(u, (u * 7 + 1) % n);
+			builder.addEdge(u, (u * 13 + 5) % n);
+		}
+		CsrGraph graph = builder.build();
+
+		vector<int> sources;
+		for (int s = 0; s < 100; ++s) {
+			sources.push_back(s * 10);
+		}
+
+		ShortestPaths shortestPaths(graph);
+		vector<vector<int>> table = shortestPaths.multiSourceBfs(sources);
+		bool same = true;
+		for (size_t i = 0; i < sources.size(); ++i) {
+			shortestPaths.bfs(sources[i]);
+			same = same && table[i] == shortestPaths.getDistances();
+		}
+		cout << "Multi-source BFS matches single-source distances: " << same << endl;
+	}
+
+	void testPointToPoint() {
+		CsrGraph graph = CsrGraphBuilder::fromEdges(6, { {0, 1}, {0, 2}, {1, 3}, {2, 4}, {3, 0}, {3, 4}, {4, 3}, {4, 5} });
+		ShortestPaths shortestPaths(graph);
+
+		for (PathSearch search : { PathSearch::EARLY_EXIT, PathSearch::BIDIRECTIONAL }) {
+			vector<int> path05 = shortestPaths.computeShortestPath(0, 5, search);
+			cout << "Point-to-point path from 0 to 5: ";
+			for (int u : path05) {
+				cout << u << " ";
+			}
+			cout << endl;
+
+			try {
+				shortestPaths.computeShortestPath(5, 0, search);
+			}
+			catch (NoPathExistsException exc) {
+				cout << "No path from 5 to 0." << endl;
+			}
+		}
+	}
 }
 
 void testShortesPaths() {
 	testShortestPath();
 	testNoPath();
+	testSharedGraph();
+	testDirectionOptimizing();
+	testMultiSourceBfs();
+	testPointToPoint();
 }
\ No newline at end of file
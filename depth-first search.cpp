@@ -7,6 +7,10 @@ using namespace std;
 
 #include <vector>
 #include <iostream>
+#include <memory>
+
+#include "Compressed Sparse Row Graph.h"
+#include "Depth-First Traversal.h"
 
 
 namespace {
@@ -14,84 +18,55 @@ namespace {
 	// shorthand for adjacency list type
 	typedef vector<vector<int>> AdjacencyList;
 
-	// define an enum for node states during DFS execution
-	enum NodeState { UNVISITED, IN_PROGRESS, FINISHED };
-
 	class CycleDetector {
 	private:
-		const AdjacencyList adjacencyList;
-		vector<NodeState> nodeStates;
-		bool cycleFound = false;
-
-	public:
-		CycleDetector(AdjacencyList _adjacencyList)
-			: adjacencyList(_adjacencyList)
-			// initialize all nodes as unvisited
-			, nodeStates(vector<NodeState>(
-				_adjacencyList.size(), 
-				NodeState::UNVISITED)) {}
-
-	private:
-		void dfs(int u) {
-			// mark current node as in progress
-			nodeStates[u] = NodeState::IN_PROGRESS;
-
-			for (int v : adjacencyList[u]) {
-				switch (nodeStates[v]) {
-					// discovery edge: recursively call dfs
-					case NodeState::UNVISITED: dfs(v); break;
-
-					// back edge: mark cycle as found
-					case NodeState::IN_PROGRESS: cycleFound = true; break;
-
-					// redundant edge: skip
-					case NodeState::FINISHED: break;
-				}
+		// set only when constructed from an adjacency list, keeps the graph alive
+		shared_ptr<const CsrGraph> ownedGraph;
+		CsrGraphView graph;
+		DepthFirstSearch search;
+
+		// a back edge closes a cycle, stop right there
+		struct DirectedVisitor : DfsVisitor {
+			bool backEdge(int, int) { return false; }
+		};
+
+		// in an undirected graph the edge back to the parent is the tree edge
+		// itself, any other edge to a node in progress closes a cycle
+		struct UndirectedVisitor : DfsVisitor {
+			vector<int>& parents;
+
+			explicit UndirectedVisitor(vector<int>& _parents) : parents(_parents) {}
+
+			bool discover(int u, int parent) {
+				parents[u] = parent;
+				return true;
 			}
 
-			// mark current node as done 
-			nodeStates[u] = FINISHED;
-		}
+			bool backEdge(int u, int v) { return v == parents[u]; }
+		};
 
-		// keep track of parent vertex, default -1 (no parent)
-		void dfs(int u, int parent) {
-			nodeStates[u] = NodeState::IN_PROGRESS;
-
-			for (int v : adjacencyList[u]) {
-				// skip edge back to the parent
-				if (parent == v) continue;
-
-				switch (nodeStates[v])
-				{
-					// call dfs and pass the parent
-					case NodeState::UNVISITED: dfs(v, u); break;
-					case NodeState::IN_PROGRESS: cycleFound = true; break;
-					case NodeState::FINISHED: break;
-				}
-			}
+	public:
+		CycleDetector(const AdjacencyList& _adjacencyList)
+			: ownedGraph(make_shared<const CsrGraph>(_adjacencyList))
+			, graph(ownedGraph->view())
+			, search(graph) {}
 
-			nodeStates[u] = NodeState::FINISHED;
-		}
+		// zero-copy: the caller keeps the CsrGraph alive
+		CycleDetector(CsrGraphView _graph)
+			: graph(_graph)
+			, search(graph) {}
 
-	public:
 		bool containsCycle() {
-			for (int u = 0; u < adjacencyList.size(); ++u) {
-				// skip nodes that were already discovered
-				if (nodeStates[u] == NodeState::FINISHED) continue;
-				dfs(u);
-			}
-
-			return cycleFound;
+			search.reset();
+			DirectedVisitor visitor;
+			return !search.runAll(visitor);
 		}
 
 		bool containsCycleUndirected() {
-			for (int u = 0; u < adjacencyList.size(); ++u) {
-				// skip nodes that were already discovered
-				if (nodeStates[u] == NodeState::FINISHED) continue;
-				dfs(u, -1);
-			}
-
-			return cycleFound;
+			search.reset();
+			vector<int> parents(graph.size(), DfsVisitor::NO_PARENT);
+			UndirectedVisitor visitor(parents);
+			return !search.runAll(visitor);
 		}
 	};
 
@@ -118,9 +93,23 @@ namespace {
 		CycleDetector cycleDetector(adjacencyList);
 		cout << "Contains cycle: " << cycleDetector.containsCycle() << endl;
 	}
+
+	void testDeepPath() {
+		// a recursive DFS would overflow the stack here
+		int n = 1'000'000;
+		CsrGraphBuilder builder(n);
+		for (int u = 0; u + 1 < n; ++u) {
+			builder.addEdge(u, u + 1);
+		}
+		CsrGraph path = builder.build();
+
+		CycleDetector cycleDetector(path);
+		cout << "Path of " << n << " nodes contains cycle: " << cycleDetector.containsCycle() << endl;
+	}
 } // namespace
 
 void testCycleDetector() {
 	testGraphWithCycle();
 	testGraphNoCycle();
+	testDeepPath();
 }